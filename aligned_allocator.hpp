@@ -0,0 +1,117 @@
+/**
+ * @file aligned_allocator.hpp
+ *
+ * Standard allocator handing out memory aligned to A bytes (a cache line
+ * by default), e.g. for sample vectors read and written by simd kernels
+ * and by different threads.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _ALIGNED_ALLOCATOR_HPP_
+#define _ALIGNED_ALLOCATOR_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstddef>
+#include <new>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#if !defined(CACHELINE_SIZE)
+#define CACHELINE_SIZE 64
+#endif
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T, std::size_t A = CACHELINE_SIZE>
+class aligned_allocator
+{
+public:
+    static_assert((A & (A - 1)) == 0, "A must be power of 2");
+
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, A>;
+    };
+
+    constexpr aligned_allocator() noexcept = default;
+
+    template<typename U>
+    constexpr aligned_allocator(const aligned_allocator<U, A>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{A}));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        (void)n;
+        ::operator delete(p, std::align_val_t{A});
+    }
+};
+
+template<typename T, typename U, std::size_t A>
+constexpr bool operator == (const aligned_allocator<T, A>&, const aligned_allocator<U, A>&)
+{
+    return true;
+}
+
+template<typename T, typename U, std::size_t A>
+constexpr bool operator != (const aligned_allocator<T, A>&, const aligned_allocator<U, A>&)
+{
+    return false;
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _ALIGNED_ALLOCATOR_HPP_ */
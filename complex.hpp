@@ -150,8 +150,11 @@ public:
 
     constexpr complex& operator *= (const complex& other)
     {
-        m_re = m_re * other.m_re - m_im * other.m_im;
-        m_im = m_re * other.m_im + m_im * other.m_re;
+        T re = m_re * other.m_re - m_im * other.m_im;
+        T im = m_re * other.m_im + m_im * other.m_re;
+
+        m_re = re;
+        m_im = im;
         return *this;
     }
 
@@ -362,6 +365,9 @@ constexpr bool operator != (T lhs, const complex<T>& rhs)
     return !(lhs == rhs);
 }
 
+static_assert((complex<int>(1, 2) *= complex<int>(3, 4)) == complex<int>(-5, 10),
+    "complex *= complex shall be a complex multiplication");
+
 } /* end of namespace ymn */
 
 /*===========================================================================*\
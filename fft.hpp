@@ -1,7 +1,7 @@
 /**
  * @file fft.hpp
  *
- * fft based on jjj.de/fxt/fxtbook.pdf (radix-2 fft algorithms)
+ * fft based on jjj.de/fxt/fxtbook.pdf (radix-2 and radix-4 fft algorithms)
  *
  * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
  *
@@ -22,6 +22,8 @@
  * system header files
 \*===========================================================================*/
 #include <algorithm>
+#include <vector>
+#include <cstdint>
 
 /*===========================================================================*\
  * project header files
@@ -40,6 +42,130 @@
 namespace ymn
 {
 
+enum class fft_radix
+{
+    radix2, /* log2(N) radix-2 passes */
+    radix4, /* log2(N)/2 radix-4 passes (plus one radix-2 pass for odd log2(N)) */
+};
+
+struct fft_swap
+{
+    uint32_t n;
+    uint32_t m;
+};
+
+/* butterflies of an fft specialised at compile time for one particular size */
+/* (w are the per-stage twiddle tables of an fft_plan) */
+template<typename T>
+using fft_kernel = void (*)(complex<T>* iq, const complex<T>* w);
+
+template<typename T>
+inline fft_kernel<T> fft_static_kernel(std::size_t N, fft_radix radix);
+
+/*
+ * Per-stage twiddle tables - every butterfly pass reads its twiddles sequentially.
+ * Radix-2 stage with sub-transforms of size 2 * mh holds w[j] = e[j * N / (2 * mh)],
+ * j < mh, and all of them (mh = 1, 2, ..., N / 2) are stored one after another.
+ * Radix-4 stage with sub-transforms of size 4 * q holds three tables, one after another,
+ * wk[j] = e[k * j * N / (4 * q)], j < q, and follows radix-2 tables (q = 1, 2, ..., N / 4).
+ */
+constexpr std::size_t fft_radix2_twiddles_offset(std::size_t mh)
+{
+    return mh - 1;
+}
+
+constexpr std::size_t fft_radix4_twiddles_offset(std::size_t N, std::size_t q)
+{
+    return (N - 1) + 3 * (q - 1);
+}
+
+constexpr std::size_t fft_twiddles_size(std::size_t N, fft_radix radix)
+{
+    return (N - 1) + (((radix == fft_radix::radix4) && (N >= 4)) ? 3 * (N / 2 - 1) : 0);
+}
+
+/* Everything which depends only on fft size, computed once and reused for every frame */
+template<typename T>
+class fft_plan
+{
+public:
+    explicit fft_plan(const complex<T>* e, std::size_t N, fft_radix radix = fft_radix::radix4) :
+        m_size{N},
+        m_radix{radix},
+        m_twiddles(fft_twiddles_size(N, radix)),
+        m_twiddles_dup(m_twiddles.size() * 4),
+        m_swaps{},
+        m_kernel{fft_static_kernel<T>(N, radix)}
+    {
+        for (std::size_t mh = 1; mh < N; mh *= 2)
+            for (std::size_t j = 0; j < mh; ++j)
+                m_twiddles[fft_radix2_twiddles_offset(mh) + j] = e[j * (N / (2 * mh))];
+
+        if (m_twiddles.size() > (N - 1))
+            for (std::size_t q = 1; q <= N / 4; q *= 2)
+                for (std::size_t j = 0; j < q; ++j)
+                    for (std::size_t k = 1; k <= 3; ++k)
+                        m_twiddles[fft_radix4_twiddles_offset(N, q) + (k - 1) * q + j] = e[k * j * (N / (4 * q))];
+
+        /* (re, re, im, im) - ready to be loaded into simd registers without any shuffling */
+        for (std::size_t i = 0; i < m_twiddles.size(); ++i) {
+            m_twiddles_dup[4 * i + 0] = m_twiddles[i].real();
+            m_twiddles_dup[4 * i + 1] = m_twiddles[i].real();
+            m_twiddles_dup[4 * i + 2] = m_twiddles[i].imag();
+            m_twiddles_dup[4 * i + 3] = m_twiddles[i].imag();
+        }
+
+        /* bit reversal permutation as a list of (n, m) pairs to be swapped */
+        for (std::size_t n = 1, m = 0; n < N; ++n) {
+            std::size_t l = N;
+            do
+                l /= 2;
+            while (m + l >= N);
+            m = (m & (l - 1)) + l;
+            if (m > n)
+                m_swaps.push_back(fft_swap{static_cast<uint32_t>(n), static_cast<uint32_t>(m)});
+        }
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    fft_radix radix() const
+    {
+        return m_radix;
+    }
+
+    const complex<T>* twiddles() const /* per-stage tables */
+    {
+        return m_twiddles.data();
+    }
+
+    const T* twiddles_dup() const /* per-stage tables with duplicated real and imaginary parts */
+    {
+        return m_twiddles_dup.data();
+    }
+
+    const std::vector<fft_swap>& swaps() const
+    {
+        return m_swaps;
+    }
+
+    fft_kernel<T> kernel() const /* nullptr if there is no specialisation for this size */
+    {
+        return m_kernel;
+    }
+
+private:
+    std::size_t m_size;
+    fft_radix m_radix;
+    std::vector<complex<T>> m_twiddles;
+    std::vector<T> m_twiddles_dup;
+    std::vector<fft_swap> m_swaps;
+    fft_kernel<T> m_kernel;
+};
+
 } /* end of namespace ymn */
 
 /*===========================================================================*\
@@ -64,6 +190,14 @@ inline void fft_reorder_samples(complex<T>* iq, const size_t N)
     }
 }
 
+template<typename T>
+inline void fft_reorder_samples(complex<T>* iq, const std::vector<fft_swap>& swaps)
+{
+    /* decimation in time - re-order samples (in place) using precomputed swap list */
+    for (const fft_swap& swap : swaps)
+        std::swap(iq[swap.n], iq[swap.m]);
+}
+
 template<typename T>
 inline void fft_reorder_coefficients(complex<T>* iq, const size_t N)
 {
@@ -73,34 +207,349 @@ inline void fft_reorder_coefficients(complex<T>* iq, const size_t N)
 }
 
 template<typename T>
-inline void fft(complex<T>* iq, const complex<T>* e, const size_t N)
+inline bool fft_quarter_positive(const complex<T>* w, const size_t N)
+{
+    /* e[N/4] is the middle entry of the last radix-2 stage table */
+    return w[fft_radix2_twiddles_offset(N / 2) + N / 4].imag() > T();
+}
+
+template<typename T>
+inline void fft_radix2_pass(complex<T>* iq, const complex<T>* w, const size_t N, const size_t mh)
+{
+    /* one radix-2 butterfly pass over sub-transforms of size 2 * mh, */
+    /* w is the table of that stage (mh entries) */
+    const size_t m = mh * 2;
+
+    for (size_t j = 0; j < mh; ++j) {
+        const complex<T> wj = w[j];
+        for (size_t r = 0; r < N; r += m) {
+            complex<T> u = iq[r + j];
+            complex<T> v = iq[r + j + mh] * wj;
+
+            iq[r + j] = u + v;
+            iq[r + j + mh] = u - v;
+        }
+    }
+}
+
+template<typename T>
+inline complex<T> fft_rotate_quarter(const complex<T>& c, const bool positive)
+{
+    /* multiplication by e[N/4], which is either +i or -i */
+    return positive ?
+        complex<T>(-c.imag(), c.real()) :
+        complex<T>(c.imag(), -c.real());
+}
+
+template<typename T>
+inline void fft_radix4_pass(complex<T>* iq, const complex<T>* w, const size_t N, const size_t q, const bool positive)
+{
+    /* one radix-4 butterfly pass over sub-transforms of size 4 * q */
+    /* (equivalent of two radix-2 passes, but with 3 instead of 4 complex multiplications), */
+    /* w are the tables of that stage (w1, w2 and w3, q entries each) */
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; ++j) {
+        const complex<T> w1 = w[j];
+        const complex<T> w2 = w[j + q];
+        const complex<T> w3 = w[j + q * 2];
+        for (size_t r = 0; r < N; r += m) {
+            /* samples are in radix-2 bit reversed order, */
+            /* thus sub-transforms are of x[4k], x[4k+2], x[4k+1] and x[4k+3] */
+            complex<T> a = iq[r + j];
+            complex<T> b = iq[r + j + q] * w2;
+            complex<T> c = iq[r + j + q * 2] * w1;
+            complex<T> d = iq[r + j + q * 3] * w3;
+
+            complex<T> t0 = a + b;
+            complex<T> t1 = a - b;
+            complex<T> t2 = c + d;
+            complex<T> t3 = fft_rotate_quarter(c - d, positive);
+
+            iq[r + j] = t0 + t2;
+            iq[r + j + q] = t1 + t3;
+            iq[r + j + q * 2] = t0 - t2;
+            iq[r + j + q * 3] = t1 - t3;
+        }
+    }
+}
+
+template<typename T>
+inline void fft_radix2(complex<T>* iq, const complex<T>* w, const size_t N)
+{
+    for (size_t mh = 1; mh < N; mh *= 2)
+        fft_radix2_pass(iq, w + fft_radix2_twiddles_offset(mh), N, mh);
+}
+
+template<typename T>
+inline void fft_radix4(complex<T>* iq, const complex<T>* w, const size_t N)
+{
+    const bool positive = fft_quarter_positive(w, N);
+    size_t q = 1;
+
+    if (ilog2(N) & 1) {
+        /* odd power of 2 - start with one radix-2 pass */
+        fft_radix2_pass(iq, w + fft_radix2_twiddles_offset(1), N, 1);
+        q = 2;
+    }
+
+    for (; q < N; q *= 4)
+        fft_radix4_pass(iq, w + fft_radix4_twiddles_offset(N, q), N, q, positive);
+}
+
+template<typename T>
+inline void fft_butterflies(complex<T>* iq, const complex<T>* w, const size_t N, const fft_radix radix)
+{
+    /* w are the per-stage tables of a plan built for the same size and radix */
+    if ((radix == fft_radix::radix4) && (N >= 4))
+        fft_radix4(iq, w, N);
+    else
+        fft_radix2(iq, w, N);
+}
+
+template<typename T, std::size_t N, std::size_t mh>
+inline void fft_radix2_pass_static(complex<T>* iq, const complex<T>* w)
+{
+    constexpr std::size_t m = mh * 2;
+    const complex<T>* ws = w + fft_radix2_twiddles_offset(mh);
+
+    /* j == 0 uses e[0] == 1, so it needs no multiplication */
+    for (std::size_t r = 0; r < N; r += m) {
+        complex<T> u = iq[r];
+        complex<T> v = iq[r + mh];
+
+        iq[r] = u + v;
+        iq[r + mh] = u - v;
+    }
+
+    for (std::size_t j = 1; j < mh; ++j) {
+        const complex<T> wj = ws[j];
+        for (std::size_t r = 0; r < N; r += m) {
+            complex<T> u = iq[r + j];
+            complex<T> v = iq[r + j + mh] * wj;
+
+            iq[r + j] = u + v;
+            iq[r + j + mh] = u - v;
+        }
+    }
+}
+
+template<typename T, std::size_t N, std::size_t q>
+inline void fft_radix4_pass_static(complex<T>* iq, const complex<T>* w)
+{
+    constexpr std::size_t m = q * 4;
+    const complex<T>* ws = w + fft_radix4_twiddles_offset(N, q);
+    const bool positive = fft_quarter_positive(w, N);
+
+    /* j == 0 uses e[0] == 1, so it needs no multiplication */
+    for (std::size_t r = 0; r < N; r += m) {
+        complex<T> a = iq[r];
+        complex<T> b = iq[r + q];
+        complex<T> c = iq[r + q * 2];
+        complex<T> d = iq[r + q * 3];
+
+        complex<T> t0 = a + b;
+        complex<T> t1 = a - b;
+        complex<T> t2 = c + d;
+        complex<T> t3 = fft_rotate_quarter(c - d, positive);
+
+        iq[r] = t0 + t2;
+        iq[r + q] = t1 + t3;
+        iq[r + q * 2] = t0 - t2;
+        iq[r + q * 3] = t1 - t3;
+    }
+
+    for (std::size_t j = 1; j < q; ++j) {
+        const complex<T> w1 = ws[j];
+        const complex<T> w2 = ws[j + q];
+        const complex<T> w3 = ws[j + q * 2];
+        for (std::size_t r = 0; r < N; r += m) {
+            complex<T> a = iq[r + j];
+            complex<T> b = iq[r + j + q] * w2;
+            complex<T> c = iq[r + j + q * 2] * w1;
+            complex<T> d = iq[r + j + q * 3] * w3;
+
+            complex<T> t0 = a + b;
+            complex<T> t1 = a - b;
+            complex<T> t2 = c + d;
+            complex<T> t3 = fft_rotate_quarter(c - d, positive);
+
+            iq[r + j] = t0 + t2;
+            iq[r + j + q] = t1 + t3;
+            iq[r + j + q * 2] = t0 - t2;
+            iq[r + j + q * 3] = t1 - t3;
+        }
+    }
+}
+
+template<typename T, std::size_t N, std::size_t q>
+inline void fft_radix4_passes_static(complex<T>* iq, const complex<T>* w)
+{
+    if constexpr (q < N) {
+        fft_radix4_pass_static<T, N, q>(iq, w);
+        fft_radix4_passes_static<T, N, q * 4>(iq, w);
+    }
+}
+
+template<typename T, std::size_t N>
+inline void fft_radix4_static(complex<T>* iq, const complex<T>* w)
+{
+    static_assert(is_power_of_two(N), "N must be power of 2");
+
+    if constexpr (ilog2(N) & 1) {
+        fft_radix2_pass_static<T, N, 1>(iq, w);
+        fft_radix4_passes_static<T, N, 2>(iq, w);
+    }
+    else
+        fft_radix4_passes_static<T, N, 1>(iq, w);
+}
+
+template<typename T>
+inline fft_kernel<T> fft_static_kernel(std::size_t N, fft_radix radix)
 {
-    fft_reorder_samples(iq, N);
+    if (radix != fft_radix::radix4)
+        return nullptr;
 
+    switch (N) {
+        case    64: return fft_radix4_static<T,    64>;
+        case   128: return fft_radix4_static<T,   128>;
+        case   256: return fft_radix4_static<T,   256>;
+        case   512: return fft_radix4_static<T,   512>;
+        case  1024: return fft_radix4_static<T,  1024>;
+        case  2048: return fft_radix4_static<T,  2048>;
+        case  4096: return fft_radix4_static<T,  4096>;
+        case  8192: return fft_radix4_static<T,  8192>;
+        case 16384: return fft_radix4_static<T, 16384>;
+        case 32768: return fft_radix4_static<T, 32768>;
+        case 65536: return fft_radix4_static<T, 65536>;
+        default:    return nullptr;
+    }
+}
+
+template<typename T>
+inline void fft(const fft_plan<T>& plan, complex<T>* iq)
+{
+    fft_reorder_samples(iq, plan.swaps());
+    if (plan.kernel())
+        plan.kernel()(iq, plan.twiddles());
+    else
+        fft_butterflies(iq, plan.twiddles(), plan.size(), plan.radix());
+    fft_reorder_coefficients(iq, plan.size());
+}
+
+template<typename T>
+inline void fft(complex<T>* iq, const complex<T>* e, const size_t N, const fft_radix radix = fft_radix::radix4)
+{
+    /* one-off transform - twiddle tables are built on every call, use fft_plan for repeated ones */
+    fft(fft_plan<T>(e, N, radix), iq);
+}
+
+template<typename T>
+inline void fft_stockham_radix2_pass(complex<T>* y, const complex<T>* x, const complex<T>* w,
+    const size_t N, const size_t n, const bool shift)
+{
+    /* decimation in frequency, sub-transforms of length n with stride s = N / n, */
+    /* w is the table of radix-2 stage with mh = n / 2 */
+    /* when y == x (allowed only for the last pass, n == 2) the pass runs in place */
+    const size_t m = n / 2;
+    const size_t s = N / n;
+    const size_t r0 = shift ? 1 : 0; /* fftshift folded into the last pass */
+
+    for (size_t p = 0; p < m; ++p) {
+        const complex<T> wp = w[p];
+        for (size_t q = 0; q < s; ++q) {
+            complex<T> a = x[q + s * p];
+            complex<T> b = x[q + s * (p + m)];
+
+            y[q + s * (2 * p + (r0 ^ 0))] = a + b;
+            y[q + s * (2 * p + (r0 ^ 1))] = (a - b) * wp;
+        }
+    }
+}
+
+template<typename T>
+inline void fft_stockham_radix4_pass(complex<T>* y, const complex<T>* x, const complex<T>* w,
+    const size_t N, const size_t n, const bool shift, const bool positive)
+{
+    /* decimation in frequency, sub-transforms of length n with stride s = N / n, */
+    /* w is the table of radix-4 stage with q = n / 4 */
+    /* when y == x (allowed only for the last pass, n == 4) the pass runs in place */
+    const size_t m = n / 4;
+    const size_t s = N / n;
+    const size_t r0 = shift ? 2 : 0; /* fftshift folded into the last pass */
+
+    for (size_t p = 0; p < m; ++p) {
+        const complex<T> w1 = w[p];
+        const complex<T> w2 = w[p + m];
+        const complex<T> w3 = w[p + m * 2];
+        for (size_t q = 0; q < s; ++q) {
+            complex<T> a = x[q + s * p];
+            complex<T> b = x[q + s * (p + m)];
+            complex<T> c = x[q + s * (p + m * 2)];
+            complex<T> d = x[q + s * (p + m * 3)];
+
+            complex<T> apc = a + c;
+            complex<T> amc = a - c;
+            complex<T> bpd = b + d;
+            complex<T> jbmd = fft_rotate_quarter(b - d, positive);
+
+            y[q + s * (4 * p + (r0 ^ 0))] = apc + bpd;
+            y[q + s * (4 * p + (r0 ^ 1))] = (amc + jbmd) * w1;
+            y[q + s * (4 * p + (r0 ^ 2))] = (apc - bpd) * w2;
+            y[q + s * (4 * p + (r0 ^ 3))] = (amc - jbmd) * w3;
+        }
+    }
+}
+
+template<typename T>
+inline void fft_stockham(complex<T>* iq, complex<T>* scratch, const complex<T>* w, const size_t N,
+    const fft_radix radix = fft_radix::radix4)
+{
+    /* Stockham auto-sort fft - passes ping-pong between iq and scratch, */
+    /* results end up in iq already in natural, dc-centred order */
+    /* (no bit reversal permutation nor fftshift pass needed) */
     const int log2_N = ilog2(N);
+    const bool radix4 = (radix == fft_radix::radix4) && (N >= 4);
+    const int passes = radix4 ? (log2_N + 1) / 2 : log2_N;
+    const bool positive = radix4 && fft_quarter_positive(w, N);
 
-    for (int log2_n = 0; log2_n < log2_N; ++log2_n) {
-        int mh = 1 << log2_n;
-        int m = mh * 2;
-        for (int j = 0; j < mh; ++j) {
-            for (int r = 0; r < static_cast<int>(N); r += m) {
-                complex<T> u = iq[r + j];
-                complex<T> v = iq[r + j + mh] * e[j];
-
-                iq[r + j] = u + v;
-                iq[r + j + mh] = u - v;
-            }
+    complex<T>* src = iq;
+    complex<T>* dst = scratch;
+    size_t n = N;
+
+    for (int pass = 0; pass < passes; ++pass) {
+        const bool last = (pass == passes - 1);
+        if (last)
+            dst = iq; /* the last pass reads and writes the same elements, so it can be done in place */
+
+        if (radix4 && !((log2_N & 1) && (pass == 0))) {
+            fft_stockham_radix4_pass(dst, src, w + fft_radix4_twiddles_offset(N, n / 4), N, n, last, positive);
+            n /= 4;
+        }
+        else {
+            /* radix-2 only, or one leading radix-2 pass for odd log2(N) */
+            fft_stockham_radix2_pass(dst, src, w + fft_radix2_twiddles_offset(n / 2), N, n, last);
+            n /= 2;
         }
+
+        std::swap(src, dst);
     }
+}
 
-    fft_reorder_coefficients(iq, N);
+template<typename T>
+inline void fft_stockham(const fft_plan<T>& plan, complex<T>* iq, complex<T>* scratch)
+{
+    fft_stockham(iq, scratch, plan.twiddles(), plan.size(), plan.radix());
 }
 
 template<typename T, std::size_t N>
 inline void fft(complex<T> (&iq)[N], const complex<T> (&e)[N])
 {
     static_assert(is_power_of_two(N), "N must be power of 2");
-    fft(&iq, &e, N);
+    const fft_plan<T> plan(e, N, fft_radix::radix4);
+    fft_reorder_samples(iq, plan.swaps());
+    fft_radix4_static<T, N>(iq, plan.twiddles());
+    fft_reorder_coefficients(iq, N);
 }
 
 } /* end of namespace ymn */
@@ -0,0 +1,337 @@
+/**
+ * @file fft_batch.hpp
+ *
+ * Batched fft - K frames of the same size are transformed together.
+ * Frames are gathered (already in bit reversed order) into a
+ * lane-interleaved, split real/imaginary layout: re[n * K + k] holds
+ * real part of sample n of frame k. This way every simd lane performs
+ * the same butterfly on a different frame, also in the early passes
+ * where butterflies of a single frame are too short to fill a register.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FFT_BATCH_
+#define _FFT_BATCH_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <vector>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "complex.hpp"
+#include "fixq15.hpp"
+#include "ilog2.hpp"
+#include "fft.hpp"
+#include "fft_simd.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T, std::size_t K>
+class fft_batch_plan
+{
+public:
+    static constexpr std::size_t lanes = K;
+
+    explicit fft_batch_plan(const fft_plan<T>& plan) : /* plan shall be a radix-4 one */
+        m_plan{plan},
+        m_permutation(plan.size()),
+        m_re(plan.size() * K),
+        m_im(plan.size() * K)
+    {
+        for (std::size_t n = 0; n < plan.size(); ++n)
+            m_permutation[n] = static_cast<uint32_t>(n);
+        for (const fft_swap& swap : plan.swaps())
+            std::swap(m_permutation[swap.n], m_permutation[swap.m]);
+    }
+
+    const fft_plan<T>& plan() const
+    {
+        return m_plan;
+    }
+
+    const uint32_t* permutation() const /* bit reversal permutation */
+    {
+        return m_permutation.data();
+    }
+
+    T* re()
+    {
+        return m_re.data();
+    }
+
+    T* im()
+    {
+        return m_im.data();
+    }
+
+private:
+    const fft_plan<T>& m_plan;
+    std::vector<uint32_t> m_permutation;
+    std::vector<T> m_re;
+    std::vector<T> m_im;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T, std::size_t K>
+inline void fft_batch_radix2_pass(T* re, T* im, const complex<T>* w, const size_t N, const size_t mh)
+{
+    /* w is the table of that stage (see fft_plan) */
+    const size_t m = mh * 2;
+
+    for (size_t j = 0; j < mh; ++j) {
+        const T wr = w[j].real();
+        const T wi = w[j].imag();
+        for (size_t r = 0; r < N; r += m) {
+            T* ur = re + (r + j) * K;
+            T* ui = im + (r + j) * K;
+            T* vr = re + (r + j + mh) * K;
+            T* vi = im + (r + j + mh) * K;
+            for (size_t k = 0; k < K; ++k) {
+                T xr = vr[k] * wr - vi[k] * wi;
+                T xi = vr[k] * wi + vi[k] * wr;
+
+                vr[k] = ur[k] - xr;
+                vi[k] = ui[k] - xi;
+                ur[k] = ur[k] + xr;
+                ui[k] = ui[k] + xi;
+            }
+        }
+    }
+}
+
+template<typename T, std::size_t K>
+inline void fft_batch_radix4_pass(T* re, T* im, const complex<T>* w, const size_t N, const size_t q, const bool positive)
+{
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; ++j) {
+        const complex<T> w1 = w[j];
+        const complex<T> w2 = w[j + q];
+        const complex<T> w3 = w[j + q * 2];
+        for (size_t r = 0; r < N; r += m) {
+            T* ar = re + (r + j) * K;
+            T* ai = im + (r + j) * K;
+            T* br = re + (r + j + q) * K;
+            T* bi = im + (r + j + q) * K;
+            T* cr = re + (r + j + q * 2) * K;
+            T* ci = im + (r + j + q * 2) * K;
+            T* dr = re + (r + j + q * 3) * K;
+            T* di = im + (r + j + q * 3) * K;
+            for (size_t k = 0; k < K; ++k) {
+                T xbr = br[k] * w2.real() - bi[k] * w2.imag();
+                T xbi = br[k] * w2.imag() + bi[k] * w2.real();
+                T xcr = cr[k] * w1.real() - ci[k] * w1.imag();
+                T xci = cr[k] * w1.imag() + ci[k] * w1.real();
+                T xdr = dr[k] * w3.real() - di[k] * w3.imag();
+                T xdi = dr[k] * w3.imag() + di[k] * w3.real();
+
+                T t0r = ar[k] + xbr, t0i = ai[k] + xbi;
+                T t1r = ar[k] - xbr, t1i = ai[k] - xbi;
+                T t2r = xcr + xdr,   t2i = xci + xdi;
+                T t3r = positive ? xdi - xci : xci - xdi; /* (c - d) * (+i or -i) */
+                T t3i = positive ? xcr - xdr : xdr - xcr;
+
+                ar[k] = t0r + t2r; ai[k] = t0i + t2i;
+                br[k] = t1r + t3r; bi[k] = t1i + t3i;
+                cr[k] = t0r - t2r; ci[k] = t0i - t2i;
+                dr[k] = t1r - t3r; di[k] = t1i - t3i;
+            }
+        }
+    }
+}
+
+#if defined(FFT_SIMD_X86)
+
+FFT_TARGET_AVX2
+inline void fft_batch_cmul_avx2(__m256i& vr, __m256i& vi, __m256i wr, __m256i wi)
+{
+    /* four lanes (frames) at once, partial products scaled as fixq15::operator * does */
+    __m256i re = _mm256_sub_epi64(fft_div_q15_avx2(_mm256_mul_epi32(vr, wr)), fft_div_q15_avx2(_mm256_mul_epi32(vi, wi)));
+    __m256i im = _mm256_add_epi64(fft_div_q15_avx2(_mm256_mul_epi32(vr, wi)), fft_div_q15_avx2(_mm256_mul_epi32(vi, wr)));
+    vr = re;
+    vi = im;
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_batch_load_avx2(const fixq15* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+FFT_TARGET_AVX2
+inline void fft_batch_store_avx2(fixq15* p, __m256i v)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+template<std::size_t K>
+FFT_TARGET_AVX2
+inline void fft_batch_radix4_pass_avx2(fixq15* re, fixq15* im, const complex<fixq15>* w, const size_t N, const size_t q,
+    const bool positive)
+{
+    static_assert((K % 4) == 0, "number of lanes must be multiple of 4");
+
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; ++j) {
+        const __m256i w1r = _mm256_set1_epi64x(w[j].real().value());
+        const __m256i w1i = _mm256_set1_epi64x(w[j].imag().value());
+        const __m256i w2r = _mm256_set1_epi64x(w[j + q].real().value());
+        const __m256i w2i = _mm256_set1_epi64x(w[j + q].imag().value());
+        const __m256i w3r = _mm256_set1_epi64x(w[j + q * 2].real().value());
+        const __m256i w3i = _mm256_set1_epi64x(w[j + q * 2].imag().value());
+        for (size_t r = 0; r < N; r += m) {
+            fixq15* ar = re + (r + j) * K;
+            fixq15* ai = im + (r + j) * K;
+            fixq15* br = re + (r + j + q) * K;
+            fixq15* bi = im + (r + j + q) * K;
+            fixq15* cr = re + (r + j + q * 2) * K;
+            fixq15* ci = im + (r + j + q * 2) * K;
+            fixq15* dr = re + (r + j + q * 3) * K;
+            fixq15* di = im + (r + j + q * 3) * K;
+            for (size_t k = 0; k < K; k += 4) {
+                __m256i xar = fft_batch_load_avx2(ar + k), xai = fft_batch_load_avx2(ai + k);
+                __m256i xbr = fft_batch_load_avx2(br + k), xbi = fft_batch_load_avx2(bi + k);
+                __m256i xcr = fft_batch_load_avx2(cr + k), xci = fft_batch_load_avx2(ci + k);
+                __m256i xdr = fft_batch_load_avx2(dr + k), xdi = fft_batch_load_avx2(di + k);
+
+                fft_batch_cmul_avx2(xbr, xbi, w2r, w2i);
+                fft_batch_cmul_avx2(xcr, xci, w1r, w1i);
+                fft_batch_cmul_avx2(xdr, xdi, w3r, w3i);
+
+                __m256i t0r = _mm256_add_epi64(xar, xbr), t0i = _mm256_add_epi64(xai, xbi);
+                __m256i t1r = _mm256_sub_epi64(xar, xbr), t1i = _mm256_sub_epi64(xai, xbi);
+                __m256i t2r = _mm256_add_epi64(xcr, xdr), t2i = _mm256_add_epi64(xci, xdi);
+                __m256i t3r = positive ? _mm256_sub_epi64(xdi, xci) : _mm256_sub_epi64(xci, xdi);
+                __m256i t3i = positive ? _mm256_sub_epi64(xcr, xdr) : _mm256_sub_epi64(xdr, xcr);
+
+                fft_batch_store_avx2(ar + k, _mm256_add_epi64(t0r, t2r));
+                fft_batch_store_avx2(ai + k, _mm256_add_epi64(t0i, t2i));
+                fft_batch_store_avx2(br + k, _mm256_add_epi64(t1r, t3r));
+                fft_batch_store_avx2(bi + k, _mm256_add_epi64(t1i, t3i));
+                fft_batch_store_avx2(cr + k, _mm256_sub_epi64(t0r, t2r));
+                fft_batch_store_avx2(ci + k, _mm256_sub_epi64(t0i, t2i));
+                fft_batch_store_avx2(dr + k, _mm256_sub_epi64(t1r, t3r));
+                fft_batch_store_avx2(di + k, _mm256_sub_epi64(t1i, t3i));
+            }
+        }
+    }
+}
+
+#endif /* FFT_SIMD_X86 */
+
+template<typename T, std::size_t K>
+inline void fft_batch_radix4_pass(T* re, T* im, const complex<T>* w, const size_t N, const size_t q, const bool positive,
+    const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if constexpr (std::is_same<T, fixq15>::value && ((K % 4) == 0))
+        if (isa == fft_isa::avx2)
+            return fft_batch_radix4_pass_avx2<K>(re, im, w, N, q, positive);
+#endif
+    (void)isa;
+    fft_batch_radix4_pass<T, K>(re, im, w, N, q, positive);
+}
+
+template<typename T, std::size_t K>
+inline void fft_batch(fft_batch_plan<T, K>& batch, complex<T>* const* frames, std::size_t count,
+    const fft_isa isa = fft_isa::scalar)
+{
+    /* transforms up to K frames, results end up in frames in dc-centred order (as for fft()) */
+    const size_t N = batch.plan().size();
+    fft_isa lanes_isa = isa;
+    const complex<T>* w = batch.plan().twiddles();
+    const uint32_t* permutation = batch.permutation();
+    T* re = batch.re();
+    T* im = batch.im();
+
+    if (count > K)
+        count = K;
+
+    /* fixq15 simd lanes multiply low 32 bits, a frame which could overflow them sends the batch to scalar kernels */
+    if constexpr (std::is_same<T, fixq15>::value)
+        for (size_t k = 0; (k < count) && (lanes_isa != fft_isa::scalar); ++k)
+            if (!fft_simd_fits(frames[k], N, fft_radix::radix4))
+                lanes_isa = fft_isa::scalar;
+
+    /* gather - bit reversal permutation comes for free, unused lanes are zeroed */
+    for (size_t n = 0; n < N; ++n) {
+        const size_t i = permutation[n] * K;
+        for (size_t k = 0; k < count; ++k) {
+            re[i + k] = frames[k][n].real();
+            im[i + k] = frames[k][n].imag();
+        }
+        for (size_t k = count; k < K; ++k) {
+            re[i + k] = T();
+            im[i + k] = T();
+        }
+    }
+
+    const bool positive = (N >= 4) && fft_quarter_positive(w, N);
+    size_t q = 1;
+
+    if (ilog2(N) & 1) {
+        fft_batch_radix2_pass<T, K>(re, im, w + fft_radix2_twiddles_offset(1), N, 1);
+        q = 2;
+    }
+
+    for (; q < N; q *= 4)
+        fft_batch_radix4_pass<T, K>(re, im, w + fft_radix4_twiddles_offset(N, q), N, q, positive, lanes_isa);
+
+    /* scatter - fftshift comes for free */
+    for (size_t n = 0; n < N; ++n) {
+        const size_t i = n * K;
+        const size_t o = (n + N / 2) % N;
+        for (size_t k = 0; k < count; ++k)
+            frames[k][o] = complex<T>(re[i + k], im[i + k]);
+    }
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FFT_BATCH_ */
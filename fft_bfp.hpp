@@ -0,0 +1,239 @@
+/**
+ * @file fft_bfp.hpp
+ *
+ * Block floating point fft for narrow fixed point samples.
+ * Before every butterfly pass the largest magnitude of the frame is checked
+ * against the worst case growth of that pass and, when there is not enough
+ * headroom, inputs of the pass are scaled down by one (or more) bits.
+ * Number of bits shifted out is returned as the frame exponent, i.e. the
+ * result is iq * 2^exponent.
+ * Rounding noise of every scaled pass stays in the result. For full scale
+ * q15<int16_t> frames (radix-4, against a double precision dft) the SNR is
+ * about 62 dB for a tone centred on a bin and 57-60 dB for random samples,
+ * but only 46-52 dB for a tone between bins at 2k points, 41-46 dB at 8k
+ * and 33-37 dB at 64k.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FFT_BFP_
+#define _FFT_BFP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "complex.hpp"
+#include "ilog2.hpp"
+#include "fft.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+/* worst case growth of real/imaginary part magnitudes (in 1/1000), */
+/* |u| + |v| * (|wr| + |wi|) for radix-2 and |a| + 3 * |b| * (|wr| + |wi|) for radix-4 */
+#define FFT_BFP_RADIX2_GROWTH 2415
+#define FFT_BFP_RADIX4_GROWTH 5244
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+struct fft_bfp_traits
+{
+    using storage_type = decltype(std::declval<T>().value());
+
+    /* q15 words saturate at their own limits, wider ones (fixq15) are kept */
+    /* within 32 bits, as simd kernels expect */
+    static constexpr long full_scale =
+        std::min<long>(std::numeric_limits<storage_type>::max(), std::numeric_limits<int32_t>::max());
+
+    /* words which saturate at 32 bits or less (q15 ones) cannot take the growth of an unscaled fft */
+    /* (N times full scale) - they are always transformed in block floating point */
+    static constexpr bool required =
+        std::numeric_limits<storage_type>::max() <= std::numeric_limits<int32_t>::max();
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline long fft_bfp_magnitude(const complex<T>& c)
+{
+    const long re = static_cast<long>(c.real().value());
+    const long im = static_cast<long>(c.imag().value());
+
+    return std::max(re < 0 ? -re : re, im < 0 ? -im : im);
+}
+
+template<typename T>
+inline complex<T> fft_bfp_scale(const complex<T>& c, const int shift)
+{
+    /* rounding arithmetic shift right */
+    using storage_type = typename fft_bfp_traits<T>::storage_type;
+    const long round = (1L << shift) >> 1;
+
+    return complex<T>(
+        T(static_cast<storage_type>((static_cast<long>(c.real().value()) + round) >> shift)),
+        T(static_cast<storage_type>((static_cast<long>(c.imag().value()) + round) >> shift)));
+}
+
+template<typename T>
+inline int fft_bfp_shift(const long max, const long growth)
+{
+    /* smallest shift which guarantees no overflow in the pass */
+    /* (+1s account for rounding of the shift and of twiddle multiplication) */
+    int shift = 0;
+
+    while (((((max >> shift) + 1) * growth) / 1000 + 1) > fft_bfp_traits<T>::full_scale)
+        ++shift;
+
+    return shift;
+}
+
+template<typename T>
+inline long fft_bfp_radix2_pass(complex<T>* iq, const complex<T>* w, const size_t N, const size_t mh, const int shift)
+{
+    /* as fft_radix2_pass(), but inputs get scaled down by 2^shift first, */
+    /* returns the largest magnitude of the outputs (for the next headroom check) */
+    const size_t m = mh * 2;
+    long max = 0;
+
+    for (size_t j = 0; j < mh; ++j) {
+        const complex<T> wj = w[j];
+        for (size_t r = 0; r < N; r += m) {
+            complex<T> u = fft_bfp_scale(iq[r + j], shift);
+            complex<T> v = fft_bfp_scale(iq[r + j + mh], shift) * wj;
+
+            iq[r + j] = u + v;
+            iq[r + j + mh] = u - v;
+            max = std::max({max, fft_bfp_magnitude(iq[r + j]), fft_bfp_magnitude(iq[r + j + mh])});
+        }
+    }
+
+    return max;
+}
+
+template<typename T>
+inline long fft_bfp_radix4_pass(complex<T>* iq, const complex<T>* w, const size_t N, const size_t q, const bool positive,
+    const int shift)
+{
+    /* as fft_radix4_pass(), but inputs get scaled down by 2^shift first, */
+    /* returns the largest magnitude of the outputs (for the next headroom check) */
+    const size_t m = q * 4;
+    long max = 0;
+
+    for (size_t j = 0; j < q; ++j) {
+        const complex<T> w1 = w[j];
+        const complex<T> w2 = w[j + q];
+        const complex<T> w3 = w[j + q * 2];
+        for (size_t r = 0; r < N; r += m) {
+            complex<T> a = fft_bfp_scale(iq[r + j], shift);
+            complex<T> b = fft_bfp_scale(iq[r + j + q], shift) * w2;
+            complex<T> c = fft_bfp_scale(iq[r + j + q * 2], shift) * w1;
+            complex<T> d = fft_bfp_scale(iq[r + j + q * 3], shift) * w3;
+
+            complex<T> t0 = a + b;
+            complex<T> t1 = a - b;
+            complex<T> t2 = c + d;
+            complex<T> t3 = fft_rotate_quarter(c - d, positive);
+
+            iq[r + j] = t0 + t2;
+            iq[r + j + q] = t1 + t3;
+            iq[r + j + q * 2] = t0 - t2;
+            iq[r + j + q * 3] = t1 - t3;
+            max = std::max({max,
+                fft_bfp_magnitude(iq[r + j]), fft_bfp_magnitude(iq[r + j + q]),
+                fft_bfp_magnitude(iq[r + j + q * 2]), fft_bfp_magnitude(iq[r + j + q * 3])});
+        }
+    }
+
+    return max;
+}
+
+template<typename T>
+inline int fft_bfp(const fft_plan<T>& plan, complex<T>* iq)
+{
+    /* results end up in iq in dc-centred order (as for fft()), */
+    /* returned exponent tells how many bits have been shifted out on the way */
+    const size_t N = plan.size();
+    const complex<T>* w = plan.twiddles();
+    int exponent = 0;
+    long max = 0;
+
+    fft_reorder_samples(iq, plan.swaps());
+
+    for (size_t n = 0; n < N; ++n)
+        max = std::max(max, fft_bfp_magnitude(iq[n]));
+
+    if ((plan.radix() == fft_radix::radix4) && (N >= 4)) {
+        const bool positive = fft_quarter_positive(w, N);
+        size_t q = 1;
+        if (ilog2(N) & 1) {
+            const int shift = fft_bfp_shift<T>(max, FFT_BFP_RADIX2_GROWTH);
+            max = fft_bfp_radix2_pass(iq, w + fft_radix2_twiddles_offset(1), N, 1, shift);
+            exponent += shift;
+            q = 2;
+        }
+        for (; q < N; q *= 4) {
+            const int shift = fft_bfp_shift<T>(max, FFT_BFP_RADIX4_GROWTH);
+            max = fft_bfp_radix4_pass(iq, w + fft_radix4_twiddles_offset(N, q), N, q, positive, shift);
+            exponent += shift;
+        }
+    }
+    else {
+        for (size_t mh = 1; mh < N; mh *= 2) {
+            const int shift = fft_bfp_shift<T>(max, FFT_BFP_RADIX2_GROWTH);
+            max = fft_bfp_radix2_pass(iq, w + fft_radix2_twiddles_offset(mh), N, mh, shift);
+            exponent += shift;
+        }
+    }
+
+    fft_reorder_coefficients(iq, N);
+
+    return exponent;
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FFT_BFP_ */
@@ -0,0 +1,206 @@
+/**
+ * @file fft_fourstep.hpp
+ *
+ * Four-step (Bailey) fft for large transforms.
+ * N = N1 * N2 point transform is split into N1 transforms of size N2
+ * (done on cache line wide blocks of columns), twiddle multiplication,
+ * N2 transforms of size N1 (done on contiguous rows) and a final
+ * blocked transpose. All sub-transforms fit into L1/L2 cache.
+ * Twiddles e^(2*pi*i*m/N) are not tabulated for all N values of m, they
+ * are products of two factor tables (N1 + N2 entries, m = q * N2 + r).
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FFT_FOURSTEP_
+#define _FFT_FOURSTEP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <vector>
+#include <algorithm>
+
+#if !defined(CACHELINE_SIZE)
+#define CACHELINE_SIZE 64
+#endif
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "complex.hpp"
+#include "ilog2.hpp"
+#include "fft.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define FFT_FOURSTEP_TRANSPOSE_BLOCK 32
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+class fft_fourstep_plan
+{
+public:
+    /* e is the N element table of e^(2*pi*i*k/N) as for fft_plan */
+    explicit fft_fourstep_plan(const complex<T>* e, std::size_t N, fft_radix radix = fft_radix::radix4) :
+        m_size{N},
+        m_n1{std::size_t{1} << ((ilog2(N) + 1) / 2)},
+        m_n2{N / m_n1},
+        m_n1_plan{strided(e, N, m_n1).data(), m_n1, radix},
+        m_n2_plan{strided(e, N, m_n2).data(), m_n2, radix},
+        m_n2_shift{static_cast<std::size_t>(ilog2(m_n2))},
+        m_twiddles_hi(m_n1),
+        m_twiddles_lo(m_n2)
+    {
+        /* x[n1 + N1 * n2] is seen as N2 rows by N1 columns, column n1 */
+        /* after its N2 point fft gets multiplied by e^(2*pi*i*n1*k2/N) */
+        for (std::size_t q = 0; q < m_n1; ++q)
+            m_twiddles_hi[q] = e[q * m_n2];
+        for (std::size_t r = 0; r < m_n2; ++r)
+            m_twiddles_lo[r] = e[r];
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    std::size_t n1() const /* N1 - row length */
+    {
+        return m_n1;
+    }
+
+    std::size_t n2() const /* N2 - column length */
+    {
+        return m_n2;
+    }
+
+    const fft_plan<T>& n1_plan() const
+    {
+        return m_n1_plan;
+    }
+
+    const fft_plan<T>& n2_plan() const
+    {
+        return m_n2_plan;
+    }
+
+    complex<T> twiddle(std::size_t m) const /* e^(2*pi*i*m/N), m < N */
+    {
+        return m_twiddles_hi[m >> m_n2_shift] * m_twiddles_lo[m & (m_n2 - 1)];
+    }
+
+private:
+    static std::vector<complex<T>> strided(const complex<T>* e, std::size_t N, std::size_t n)
+    {
+        std::vector<complex<T>> v(n);
+
+        for (std::size_t i = 0; i < n; ++i)
+            v[i] = e[i * (N / n)];
+
+        return v;
+    }
+
+    std::size_t m_size;
+    std::size_t m_n1;
+    std::size_t m_n2;
+    fft_plan<T> m_n1_plan;
+    fft_plan<T> m_n2_plan;
+    std::size_t m_n2_shift;
+    std::vector<complex<T>> m_twiddles_hi; /* e^(2*pi*i*q*N2/N), N1 entries */
+    std::vector<complex<T>> m_twiddles_lo; /* e^(2*pi*i*r/N), N2 entries */
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline void fft_fourstep(const fft_fourstep_plan<T>& plan, complex<T>* iq, complex<T>* scratch)
+{
+    /* scratch shall hold plan.size() elements, */
+    /* results end up in iq in dc-centred order (as for fft()) */
+    const std::size_t N = plan.size();
+    const std::size_t N1 = plan.n1();
+    const std::size_t N2 = plan.n2();
+    const std::size_t B = std::max<std::size_t>(1, CACHELINE_SIZE / sizeof(complex<T>));
+
+    /* steps 1 and 2 - N2 point ffts of columns, followed by twiddle multiplication */
+    /* (B neighbouring columns are gathered at once, so whole cache lines are used) */
+    for (std::size_t n1 = 0; n1 < N1; n1 += B) {
+        const std::size_t b_max = std::min(B, N1 - n1);
+        complex<T>* column = scratch;
+
+        for (std::size_t n2 = 0; n2 < N2; ++n2)
+            for (std::size_t b = 0; b < b_max; ++b)
+                column[b * N2 + n2] = iq[n1 + b + N1 * n2];
+
+        for (std::size_t b = 0; b < b_max; ++b) {
+            fft_reorder_samples(column + b * N2, plan.n2_plan().swaps());
+            fft_butterflies(column + b * N2, plan.n2_plan().twiddles(), N2, plan.n2_plan().radix());
+            for (std::size_t k2 = 1, m = n1 + b; k2 < N2; ++k2, m = (m + n1 + b) & (N - 1))
+                column[b * N2 + k2] = column[b * N2 + k2] * plan.twiddle(m);
+        }
+
+        for (std::size_t k2 = 0; k2 < N2; ++k2)
+            for (std::size_t b = 0; b < b_max; ++b)
+                iq[n1 + b + N1 * k2] = column[b * N2 + k2];
+    }
+
+    /* step 3 - N1 point ffts of contiguous rows */
+    for (std::size_t k2 = 0; k2 < N2; ++k2) {
+        fft_reorder_samples(iq + k2 * N1, plan.n1_plan().swaps());
+        fft_butterflies(iq + k2 * N1, plan.n1_plan().twiddles(), N1, plan.n1_plan().radix());
+    }
+
+    /* step 4 - blocked transpose, X[k2 + N2 * k1] = iq[k1 + N1 * k2], */
+    /* with fftshift folded in (row k1 goes to (k1 + N1 / 2) % N1) */
+    for (std::size_t k2b = 0; k2b < N2; k2b += FFT_FOURSTEP_TRANSPOSE_BLOCK)
+        for (std::size_t k1b = 0; k1b < N1; k1b += FFT_FOURSTEP_TRANSPOSE_BLOCK)
+            for (std::size_t k1 = k1b; k1 < std::min(k1b + FFT_FOURSTEP_TRANSPOSE_BLOCK, N1); ++k1) {
+                complex<T>* dst = scratch + ((k1 + N1 / 2) % N1) * N2;
+                for (std::size_t k2 = k2b; k2 < std::min(k2b + FFT_FOURSTEP_TRANSPOSE_BLOCK, N2); ++k2)
+                    dst[k2] = iq[k1 + N1 * k2];
+            }
+
+    std::copy(scratch, scratch + N, iq);
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FFT_FOURSTEP_ */
@@ -0,0 +1,712 @@
+/**
+ * @file fft_simd.hpp
+ *
+ * SSE4.1/AVX2 butterflies for ymn::complex<ymn::fixq15> samples
+ * and AVX2/FMA ones for ymn::complex<float> samples.
+ * Kernels are selected at runtime (cpuid). The fixq15 ones multiply low
+ * 32 bits of samples, so they are bit exact with respect to the scalar
+ * ymn::fft() as long as all multiplied values fit into 32 bits - every
+ * frame is checked against that (fft_simd_fits()) and the ones which
+ * could overflow are left to scalar kernels.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FFT_SIMD_
+#define _FFT_SIMD_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FFT_SIMD_X86
+#endif
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+#include "complex.hpp"
+#include "fft.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define FFT_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define FFT_TARGET_AVX2  __attribute__((target("avx2")))
+#define FFT_TARGET_FMA   __attribute__((target("avx2,fma")))
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+enum class fft_isa
+{
+    scalar,
+    sse41,
+    avx2,      /* avx2 and fma */
+    automatic, /* best one supported by the cpu */
+};
+
+static_assert(sizeof(complex<fixq15>) == 2 * sizeof(int64_t),
+    "complex<fixq15> is expected to be a pair of int64_t");
+
+static_assert(sizeof(complex<float>) == 2 * sizeof(float),
+    "complex<float> is expected to be a pair of float");
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline fft_isa fft_isa_detect()
+{
+#if defined(FFT_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return fft_isa::avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return fft_isa::sse41;
+#endif
+    return fft_isa::scalar;
+}
+
+inline fft_isa fft_isa_resolve(fft_isa isa)
+{
+    /* downgrade requested isa to what the cpu actually supports */
+    fft_isa supported = fft_isa_detect();
+
+    if (isa == fft_isa::automatic)
+        return supported;
+
+    if (static_cast<int>(isa) > static_cast<int>(supported))
+        return supported;
+
+    return isa;
+}
+
+inline const char* fft_isa_to_string(fft_isa isa)
+{
+    switch (isa) {
+        case fft_isa::scalar:    return "scalar";
+        case fft_isa::sse41:     return "sse4.1";
+        case fft_isa::avx2:      return "avx2";
+        case fft_isa::automatic: return "auto";
+    }
+
+    return "unknown";
+}
+
+inline bool fft_isa_from_string(const char* str, fft_isa& isa)
+{
+    static const fft_isa isas[] = {fft_isa::scalar, fft_isa::sse41, fft_isa::avx2, fft_isa::automatic};
+
+    for (fft_isa i : isas)
+        if (strcmp(str, fft_isa_to_string(i)) == 0) {
+            isa = i;
+            return true;
+        }
+
+    return false;
+}
+
+#if defined(FFT_SIMD_X86)
+
+/* 128-bit register holds one complex<fixq15> (re, im), 256-bit register holds two */
+
+FFT_TARGET_SSE41
+inline __m128i fft_sign_mask_sse41(__m128i x)
+{
+    /* all ones in 64-bit lanes holding negative values */
+    return _mm_srai_epi32(_mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 1, 1)), 31);
+}
+
+FFT_TARGET_SSE41
+inline __m128i fft_div_q15_sse41(__m128i x)
+{
+    /* x / Q15 rounded towards zero (as int64_t division does) */
+    /* (sign of the biased value is used for the shift, since -Q15 < x < 0 gives 0) */
+    x = _mm_add_epi64(x, _mm_and_si128(fft_sign_mask_sse41(x), _mm_set1_epi64x(Q15 - 1)));
+    return _mm_or_si128(_mm_srli_epi64(x, 15), _mm_slli_epi64(fft_sign_mask_sse41(x), 64 - 15));
+}
+
+FFT_TARGET_SSE41
+inline __m128i fft_cmul_sse41(__m128i v, __m128i wr, __m128i wi)
+{
+    /* (vr, vi) * (wr, wi) with each partial product scaled separately, as fixq15::operator * does */
+    __m128i p1 = fft_div_q15_sse41(_mm_mul_epi32(v, wr));                                           /* (vr * wr, vi * wr) */
+    __m128i p2 = fft_div_q15_sse41(_mm_mul_epi32(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), wi)); /* (vi * wi, vr * wi) */
+    p2 = _mm_blend_epi16(_mm_sub_epi64(_mm_setzero_si128(), p2), p2, 0xF0);                           /* (-vi * wi, vr * wi) */
+    return _mm_add_epi64(p1, p2);
+}
+
+FFT_TARGET_SSE41
+inline __m128i fft_rotate_quarter_sse41(__m128i v, const bool positive)
+{
+    /* (-im, re) for +i, (im, -re) for -i */
+    __m128i s = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i n = _mm_sub_epi64(_mm_setzero_si128(), s);
+    return positive ? _mm_blend_epi16(n, s, 0xF0) : _mm_blend_epi16(s, n, 0xF0);
+}
+
+FFT_TARGET_SSE41
+inline __m128i fft_load_sse41(const complex<fixq15>* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+FFT_TARGET_SSE41
+inline void fft_store_sse41(complex<fixq15>* p, __m128i v)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+FFT_TARGET_SSE41
+inline __m128i fft_load_sse41(const fixq15* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+FFT_TARGET_SSE41
+inline void fft_radix2_pass_sse41(complex<fixq15>* iq, const fixq15* wd, const size_t N, const size_t mh)
+{
+    /* wd is the stage table with duplicated (re, re, im, im) parts */
+    const size_t m = mh * 2;
+
+    for (size_t j = 0; j < mh; ++j) {
+        const __m128i wr = fft_load_sse41(wd + 4 * j);
+        const __m128i wi = fft_load_sse41(wd + 4 * j + 2);
+        for (size_t r = 0; r < N; r += m) {
+            __m128i u = fft_load_sse41(&iq[r + j]);
+            __m128i v = fft_cmul_sse41(fft_load_sse41(&iq[r + j + mh]), wr, wi);
+
+            fft_store_sse41(&iq[r + j], _mm_add_epi64(u, v));
+            fft_store_sse41(&iq[r + j + mh], _mm_sub_epi64(u, v));
+        }
+    }
+}
+
+FFT_TARGET_SSE41
+inline void fft_radix4_pass_sse41(complex<fixq15>* iq, const fixq15* wd, const size_t N, const size_t q, const bool positive)
+{
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; ++j) {
+        const __m128i w1r = fft_load_sse41(wd + 4 * j);
+        const __m128i w1i = fft_load_sse41(wd + 4 * j + 2);
+        const __m128i w2r = fft_load_sse41(wd + 4 * (j + q));
+        const __m128i w2i = fft_load_sse41(wd + 4 * (j + q) + 2);
+        const __m128i w3r = fft_load_sse41(wd + 4 * (j + q * 2));
+        const __m128i w3i = fft_load_sse41(wd + 4 * (j + q * 2) + 2);
+        for (size_t r = 0; r < N; r += m) {
+            __m128i a = fft_load_sse41(&iq[r + j]);
+            __m128i b = fft_cmul_sse41(fft_load_sse41(&iq[r + j + q]), w2r, w2i);
+            __m128i c = fft_cmul_sse41(fft_load_sse41(&iq[r + j + q * 2]), w1r, w1i);
+            __m128i d = fft_cmul_sse41(fft_load_sse41(&iq[r + j + q * 3]), w3r, w3i);
+
+            __m128i t0 = _mm_add_epi64(a, b);
+            __m128i t1 = _mm_sub_epi64(a, b);
+            __m128i t2 = _mm_add_epi64(c, d);
+            __m128i t3 = fft_rotate_quarter_sse41(_mm_sub_epi64(c, d), positive);
+
+            fft_store_sse41(&iq[r + j], _mm_add_epi64(t0, t2));
+            fft_store_sse41(&iq[r + j + q], _mm_add_epi64(t1, t3));
+            fft_store_sse41(&iq[r + j + q * 2], _mm_sub_epi64(t0, t2));
+            fft_store_sse41(&iq[r + j + q * 3], _mm_sub_epi64(t1, t3));
+        }
+    }
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_sign_mask_avx2(__m256i x)
+{
+    return _mm256_srai_epi32(_mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 1, 1)), 31);
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_div_q15_avx2(__m256i x)
+{
+    x = _mm256_add_epi64(x, _mm256_and_si256(fft_sign_mask_avx2(x), _mm256_set1_epi64x(Q15 - 1)));
+    return _mm256_or_si256(_mm256_srli_epi64(x, 15), _mm256_slli_epi64(fft_sign_mask_avx2(x), 64 - 15));
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_cmul_avx2(__m256i v, __m256i wr, __m256i wi)
+{
+    __m256i p1 = fft_div_q15_avx2(_mm256_mul_epi32(v, wr));
+    __m256i p2 = fft_div_q15_avx2(_mm256_mul_epi32(_mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), wi));
+    p2 = _mm256_blend_epi32(_mm256_sub_epi64(_mm256_setzero_si256(), p2), p2, 0xCC);
+    return _mm256_add_epi64(p1, p2);
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_rotate_quarter_avx2(__m256i v, const bool positive)
+{
+    __m256i s = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    __m256i n = _mm256_sub_epi64(_mm256_setzero_si256(), s);
+    return positive ? _mm256_blend_epi32(n, s, 0xCC) : _mm256_blend_epi32(s, n, 0xCC);
+}
+
+FFT_TARGET_AVX2
+inline __m256i fft_load_avx2(const complex<fixq15>* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+FFT_TARGET_AVX2
+inline void fft_store_avx2(complex<fixq15>* p, __m256i v)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+FFT_TARGET_AVX2
+inline void fft_twiddles_avx2(const fixq15* wd0, const fixq15* wd1, __m256i& wr, __m256i& wi)
+{
+    /* two duplicated twiddles (re, re, im, im) -> (re0, re0, re1, re1) and (im0, im0, im1, im1) */
+    const __m256i w0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wd0));
+    const __m256i w1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wd1));
+    wr = _mm256_permute2x128_si256(w0, w1, 0x20);
+    wi = _mm256_permute2x128_si256(w0, w1, 0x31);
+}
+
+FFT_TARGET_AVX2
+inline void fft_radix2_pass_avx2(complex<fixq15>* iq, const fixq15* wd, const size_t N, const size_t mh)
+{
+    /* two neighbouring butterflies (j and j + 1) at once */
+    const size_t m = mh * 2;
+
+    for (size_t j = 0; j < mh; j += 2) {
+        __m256i wr, wi;
+        fft_twiddles_avx2(wd + 4 * j, wd + 4 * (j + 1), wr, wi);
+        for (size_t r = 0; r < N; r += m) {
+            __m256i u = fft_load_avx2(&iq[r + j]);
+            __m256i v = fft_cmul_avx2(fft_load_avx2(&iq[r + j + mh]), wr, wi);
+
+            fft_store_avx2(&iq[r + j], _mm256_add_epi64(u, v));
+            fft_store_avx2(&iq[r + j + mh], _mm256_sub_epi64(u, v));
+        }
+    }
+}
+
+FFT_TARGET_AVX2
+inline void fft_radix4_pass_avx2(complex<fixq15>* iq, const fixq15* wd, const size_t N, const size_t q, const bool positive)
+{
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; j += 2) {
+        __m256i w1r, w1i, w2r, w2i, w3r, w3i;
+        fft_twiddles_avx2(wd + 4 * j, wd + 4 * (j + 1), w1r, w1i);
+        fft_twiddles_avx2(wd + 4 * (j + q), wd + 4 * (j + q + 1), w2r, w2i);
+        fft_twiddles_avx2(wd + 4 * (j + q * 2), wd + 4 * (j + q * 2 + 1), w3r, w3i);
+        for (size_t r = 0; r < N; r += m) {
+            __m256i a = fft_load_avx2(&iq[r + j]);
+            __m256i b = fft_cmul_avx2(fft_load_avx2(&iq[r + j + q]), w2r, w2i);
+            __m256i c = fft_cmul_avx2(fft_load_avx2(&iq[r + j + q * 2]), w1r, w1i);
+            __m256i d = fft_cmul_avx2(fft_load_avx2(&iq[r + j + q * 3]), w3r, w3i);
+
+            __m256i t0 = _mm256_add_epi64(a, b);
+            __m256i t1 = _mm256_sub_epi64(a, b);
+            __m256i t2 = _mm256_add_epi64(c, d);
+            __m256i t3 = fft_rotate_quarter_avx2(_mm256_sub_epi64(c, d), positive);
+
+            fft_store_avx2(&iq[r + j], _mm256_add_epi64(t0, t2));
+            fft_store_avx2(&iq[r + j + q], _mm256_add_epi64(t1, t3));
+            fft_store_avx2(&iq[r + j + q * 2], _mm256_sub_epi64(t0, t2));
+            fft_store_avx2(&iq[r + j + q * 3], _mm256_sub_epi64(t1, t3));
+        }
+    }
+}
+
+/* 256-bit register holds four complex<float> (re, im) */
+
+FFT_TARGET_FMA
+inline __m256 fft_cmul_fma(__m256 v, __m256 w)
+{
+    /* (vr * wr - vi * wi, vi * wr + vr * wi) */
+    const __m256 wr = _mm256_moveldup_ps(w);
+    const __m256 wi = _mm256_movehdup_ps(w);
+    const __m256 s = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_fmaddsub_ps(v, wr, _mm256_mul_ps(s, wi));
+}
+
+FFT_TARGET_FMA
+inline __m256 fft_rotate_quarter_fma(__m256 v, const bool positive)
+{
+    /* (-im, re) for +i, (im, -re) for -i */
+    const __m256 s = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m256 sign = positive ?
+        _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f) :
+        _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+    return _mm256_xor_ps(s, sign);
+}
+
+FFT_TARGET_FMA
+inline __m256 fft_load_fma(const complex<float>* p)
+{
+    return _mm256_loadu_ps(reinterpret_cast<const float*>(p));
+}
+
+FFT_TARGET_FMA
+inline void fft_store_fma(complex<float>* p, __m256 v)
+{
+    _mm256_storeu_ps(reinterpret_cast<float*>(p), v);
+}
+
+FFT_TARGET_FMA
+inline void fft_transpose_fma(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    /* 4x4 transpose of complex<float> elements (64-bit each) */
+    const __m256d t0 = _mm256_unpacklo_pd(_mm256_castps_pd(r0), _mm256_castps_pd(r1));
+    const __m256d t1 = _mm256_unpackhi_pd(_mm256_castps_pd(r0), _mm256_castps_pd(r1));
+    const __m256d t2 = _mm256_unpacklo_pd(_mm256_castps_pd(r2), _mm256_castps_pd(r3));
+    const __m256d t3 = _mm256_unpackhi_pd(_mm256_castps_pd(r2), _mm256_castps_pd(r3));
+    r0 = _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x20));
+    r1 = _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x20));
+    r2 = _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x31));
+    r3 = _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+FFT_TARGET_FMA
+inline void fft_radix2_pass_1_fma(complex<float>* iq, const size_t N)
+{
+    /* first pass (mh == 1, w == 1) - butterflies are within registers, */
+    /* (u0, v0, u1, v1) and (u2, v2, u3, v3) get split into (u0, u2, u1, u3) and (v0, v2, v1, v3) */
+    for (size_t r = 0; r < N; r += 8) {
+        const __m256d x = _mm256_castps_pd(fft_load_fma(&iq[r]));
+        const __m256d y = _mm256_castps_pd(fft_load_fma(&iq[r + 4]));
+        const __m256 u = _mm256_castpd_ps(_mm256_unpacklo_pd(x, y));
+        const __m256 v = _mm256_castpd_ps(_mm256_unpackhi_pd(x, y));
+        const __m256d s = _mm256_castps_pd(_mm256_add_ps(u, v));
+        const __m256d d = _mm256_castps_pd(_mm256_sub_ps(u, v));
+
+        fft_store_fma(&iq[r], _mm256_castpd_ps(_mm256_unpacklo_pd(s, d)));
+        fft_store_fma(&iq[r + 4], _mm256_castpd_ps(_mm256_unpackhi_pd(s, d)));
+    }
+}
+
+FFT_TARGET_FMA
+inline void fft_radix4_pass_1_fma(complex<float>* iq, const size_t N, const bool positive)
+{
+    /* first pass (q == 1, all twiddles are 1) - four sub-transforms (16 samples) */
+    /* are transposed, so every register holds a, b, c or d of all of them */
+    for (size_t r = 0; r < N; r += 16) {
+        __m256 a = fft_load_fma(&iq[r]);
+        __m256 b = fft_load_fma(&iq[r + 4]);
+        __m256 c = fft_load_fma(&iq[r + 8]);
+        __m256 d = fft_load_fma(&iq[r + 12]);
+        fft_transpose_fma(a, b, c, d);
+
+        __m256 t0 = _mm256_add_ps(a, b);
+        __m256 t1 = _mm256_sub_ps(a, b);
+        __m256 t2 = _mm256_add_ps(c, d);
+        __m256 t3 = fft_rotate_quarter_fma(_mm256_sub_ps(c, d), positive);
+
+        a = _mm256_add_ps(t0, t2);
+        b = _mm256_add_ps(t1, t3);
+        c = _mm256_sub_ps(t0, t2);
+        d = _mm256_sub_ps(t1, t3);
+        fft_transpose_fma(a, b, c, d);
+
+        fft_store_fma(&iq[r], a);
+        fft_store_fma(&iq[r + 4], b);
+        fft_store_fma(&iq[r + 8], c);
+        fft_store_fma(&iq[r + 12], d);
+    }
+}
+
+FFT_TARGET_FMA
+inline void fft_radix4_pass_2_fma(complex<float>* iq, const complex<float>* w, const size_t N, const bool positive)
+{
+    /* second pass for odd log2(N) (q == 2) - two sub-transforms (16 samples) at once, */
+    /* (a0, a1, b0, b1) and (c0, c1, d0, d1) of both get paired by 128-bit halves */
+    const __m256 w1 = _mm256_castpd_ps(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(&w[0])));
+    const __m256 w2 = _mm256_castpd_ps(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(&w[2])));
+    const __m256 w3 = _mm256_castpd_ps(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(&w[4])));
+
+    for (size_t r = 0; r < N; r += 16) {
+        const __m256 x0 = fft_load_fma(&iq[r]);
+        const __m256 x1 = fft_load_fma(&iq[r + 4]);
+        const __m256 y0 = fft_load_fma(&iq[r + 8]);
+        const __m256 y1 = fft_load_fma(&iq[r + 12]);
+
+        __m256 a = _mm256_permute2f128_ps(x0, y0, 0x20);
+        __m256 b = fft_cmul_fma(_mm256_permute2f128_ps(x0, y0, 0x31), w2);
+        __m256 c = fft_cmul_fma(_mm256_permute2f128_ps(x1, y1, 0x20), w1);
+        __m256 d = fft_cmul_fma(_mm256_permute2f128_ps(x1, y1, 0x31), w3);
+
+        __m256 t0 = _mm256_add_ps(a, b);
+        __m256 t1 = _mm256_sub_ps(a, b);
+        __m256 t2 = _mm256_add_ps(c, d);
+        __m256 t3 = fft_rotate_quarter_fma(_mm256_sub_ps(c, d), positive);
+
+        a = _mm256_add_ps(t0, t2);
+        b = _mm256_add_ps(t1, t3);
+        c = _mm256_sub_ps(t0, t2);
+        d = _mm256_sub_ps(t1, t3);
+
+        fft_store_fma(&iq[r], _mm256_permute2f128_ps(a, b, 0x20));
+        fft_store_fma(&iq[r + 4], _mm256_permute2f128_ps(c, d, 0x20));
+        fft_store_fma(&iq[r + 8], _mm256_permute2f128_ps(a, b, 0x31));
+        fft_store_fma(&iq[r + 12], _mm256_permute2f128_ps(c, d, 0x31));
+    }
+}
+
+FFT_TARGET_FMA
+inline void fft_radix2_pass_fma(complex<float>* iq, const complex<float>* w, const size_t N, const size_t mh)
+{
+    /* four neighbouring butterflies (j .. j + 3) at once, mh shall be multiple of 4 */
+    const size_t m = mh * 2;
+
+    for (size_t j = 0; j < mh; j += 4) {
+        const __m256 wj = fft_load_fma(&w[j]);
+        for (size_t r = 0; r < N; r += m) {
+            __m256 u = fft_load_fma(&iq[r + j]);
+            __m256 v = fft_cmul_fma(fft_load_fma(&iq[r + j + mh]), wj);
+
+            fft_store_fma(&iq[r + j], _mm256_add_ps(u, v));
+            fft_store_fma(&iq[r + j + mh], _mm256_sub_ps(u, v));
+        }
+    }
+}
+
+FFT_TARGET_FMA
+inline void fft_radix4_pass_fma(complex<float>* iq, const complex<float>* w, const size_t N, const size_t q, const bool positive)
+{
+    /* four neighbouring butterflies (j .. j + 3) at once, q shall be multiple of 4 */
+    const size_t m = q * 4;
+
+    for (size_t j = 0; j < q; j += 4) {
+        const __m256 w1 = fft_load_fma(&w[j]);
+        const __m256 w2 = fft_load_fma(&w[j + q]);
+        const __m256 w3 = fft_load_fma(&w[j + q * 2]);
+        for (size_t r = 0; r < N; r += m) {
+            __m256 a = fft_load_fma(&iq[r + j]);
+            __m256 b = fft_cmul_fma(fft_load_fma(&iq[r + j + q]), w2);
+            __m256 c = fft_cmul_fma(fft_load_fma(&iq[r + j + q * 2]), w1);
+            __m256 d = fft_cmul_fma(fft_load_fma(&iq[r + j + q * 3]), w3);
+
+            __m256 t0 = _mm256_add_ps(a, b);
+            __m256 t1 = _mm256_sub_ps(a, b);
+            __m256 t2 = _mm256_add_ps(c, d);
+            __m256 t3 = fft_rotate_quarter_fma(_mm256_sub_ps(c, d), positive);
+
+            fft_store_fma(&iq[r + j], _mm256_add_ps(t0, t2));
+            fft_store_fma(&iq[r + j + q], _mm256_add_ps(t1, t3));
+            fft_store_fma(&iq[r + j + q * 2], _mm256_sub_ps(t0, t2));
+            fft_store_fma(&iq[r + j + q * 3], _mm256_sub_ps(t1, t3));
+        }
+    }
+}
+
+#endif /* FFT_SIMD_X86 */
+
+inline bool fft_simd_fits(const complex<fixq15>* iq, const size_t N, const fft_radix radix)
+{
+    /* values multiplied by a pass are outputs of sub-transforms of at most s = N / 4 (radix-4) or N / 2 */
+    /* (radix-2) samples, every radix-2 level at most doubles their modulus (twiddles and truncations */
+    /* add less than 0.1% and 3), so their parts stay within s * (2 * max + 4), max being the largest */
+    /* |re| or |im| of the input - that shall be below 2^31 for 32-bit lane products to be exact */
+    const size_t s = ((radix == fft_radix::radix4) && (N >= 4)) ? N / 4 : N / 2;
+    int64_t max = 0;
+
+    for (size_t n = 0; n < N; ++n)
+        max = std::max({max, std::abs(iq[n].real().value()), std::abs(iq[n].imag().value())});
+
+    return static_cast<double>(s) * (2.0 * static_cast<double>(max) + 4.0) < 2147483648.0;
+}
+
+inline void fft_radix2_pass(complex<fixq15>* iq, const complex<fixq15>* w, const fixq15* wd,
+    const size_t N, const size_t mh, const fft_isa isa)
+{
+    /* w and wd are the tables of that stage, plain and duplicated ones */
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && (mh >= 2))
+        return fft_radix2_pass_avx2(iq, wd, N, mh);
+    if (isa != fft_isa::scalar)
+        return fft_radix2_pass_sse41(iq, wd, N, mh);
+#endif
+    (void)wd;
+    fft_radix2_pass(iq, w, N, mh);
+}
+
+inline void fft_radix4_pass(complex<fixq15>* iq, const complex<fixq15>* w, const fixq15* wd,
+    const size_t N, const size_t q, const bool positive, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && (q >= 2))
+        return fft_radix4_pass_avx2(iq, wd, N, q, positive);
+    if (isa != fft_isa::scalar)
+        return fft_radix4_pass_sse41(iq, wd, N, q, positive);
+#endif
+    (void)wd;
+    fft_radix4_pass(iq, w, N, q, positive);
+}
+
+inline void fft_butterflies(complex<fixq15>* iq, const complex<fixq15>* w, const fixq15* wd,
+    const size_t N, const fft_radix radix, const fft_isa isa)
+{
+    /* isa shall be already resolved (see fft_isa_resolve()), */
+    /* w and wd are the per-stage tables of a plan (see fft_plan::twiddles() and twiddles_dup()) */
+    if ((radix == fft_radix::radix4) && (N >= 4)) {
+        const bool positive = fft_quarter_positive(w, N);
+        size_t q = 1;
+        if (ilog2(N) & 1) {
+            fft_radix2_pass(iq, w, wd, N, 1, isa);
+            q = 2;
+        }
+        for (; q < N; q *= 4) {
+            const size_t offset = fft_radix4_twiddles_offset(N, q);
+            fft_radix4_pass(iq, w + offset, wd + 4 * offset, N, q, positive, isa);
+        }
+    }
+    else {
+        for (size_t mh = 1; mh < N; mh *= 2) {
+            const size_t offset = fft_radix2_twiddles_offset(mh);
+            fft_radix2_pass(iq, w + offset, wd + 4 * offset, N, mh, isa);
+        }
+    }
+}
+
+inline void fft(const fft_plan<fixq15>& plan, complex<fixq15>* iq, const fft_isa isa)
+{
+    /* frames which could overflow 32-bit lane products go through scalar kernels */
+    if ((isa == fft_isa::scalar) || !fft_simd_fits(iq, plan.size(), plan.radix()))
+        return fft(plan, iq); /* compile time specialised kernels (if any) */
+
+    fft_reorder_samples(iq, plan.swaps());
+    fft_butterflies(iq, plan.twiddles(), plan.twiddles_dup(), plan.size(), plan.radix(), isa);
+    fft_reorder_coefficients(iq, plan.size());
+}
+
+inline void fft(complex<fixq15>* iq, const complex<fixq15>* e, const size_t N, const fft_radix radix, const fft_isa isa)
+{
+    /* one-off transform - twiddle tables are built on every call, use fft_plan for repeated ones */
+    fft(fft_plan<fixq15>(e, N, radix), iq, isa);
+}
+
+inline void fft_radix2_pass(complex<float>* iq, const complex<float>* w, const size_t N, const size_t mh, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && (mh >= 4))
+        return fft_radix2_pass_fma(iq, w, N, mh);
+    if ((isa == fft_isa::avx2) && (mh == 1) && (N >= 8))
+        return fft_radix2_pass_1_fma(iq, N);
+#endif
+    (void)isa;
+    fft_radix2_pass(iq, w, N, mh);
+}
+
+inline void fft_radix4_pass(complex<float>* iq, const complex<float>* w, const size_t N, const size_t q, const bool positive,
+    const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && (q >= 4))
+        return fft_radix4_pass_fma(iq, w, N, q, positive);
+    if ((isa == fft_isa::avx2) && (q == 1) && (N >= 16))
+        return fft_radix4_pass_1_fma(iq, N, positive);
+    if ((isa == fft_isa::avx2) && (q == 2) && (N >= 16))
+        return fft_radix4_pass_2_fma(iq, w, N, positive);
+#endif
+    (void)isa;
+    fft_radix4_pass(iq, w, N, q, positive);
+}
+
+inline void fft_butterflies(complex<float>* iq, const complex<float>* w, const size_t N, const fft_radix radix, const fft_isa isa)
+{
+    /* no sse4.1 kernels for float, only avx2 (and fma) ones */
+    if ((radix == fft_radix::radix4) && (N >= 4)) {
+        const bool positive = fft_quarter_positive(w, N);
+        size_t q = 1;
+        if (ilog2(N) & 1) {
+            fft_radix2_pass(iq, w + fft_radix2_twiddles_offset(1), N, 1, isa);
+            q = 2;
+        }
+        for (; q < N; q *= 4)
+            fft_radix4_pass(iq, w + fft_radix4_twiddles_offset(N, q), N, q, positive, isa);
+    }
+    else {
+        for (size_t mh = 1; mh < N; mh *= 2)
+            fft_radix2_pass(iq, w + fft_radix2_twiddles_offset(mh), N, mh, isa);
+    }
+}
+
+inline void fft(const fft_plan<float>& plan, complex<float>* iq, const fft_isa isa)
+{
+    if (isa != fft_isa::avx2)
+        return fft(plan, iq); /* compile time specialised kernels (if any) */
+
+    fft_reorder_samples(iq, plan.swaps());
+    fft_butterflies(iq, plan.twiddles(), plan.size(), plan.radix(), isa);
+    fft_reorder_coefficients(iq, plan.size());
+}
+
+template<typename T>
+inline void fft(const fft_plan<T>& plan, complex<T>* iq, const fft_isa isa)
+{
+    /* simd kernels are there for complex<fixq15> and complex<float> only, other types use scalar ones */
+    (void)isa;
+    fft(plan, iq);
+}
+
+template<typename T>
+inline bool fft_verify(const complex<T>* iq, const complex<T>* reference, const size_t N)
+{
+    /* bit exact comparison of simd output against scalar one */
+    return memcmp(iq, reference, N * sizeof(complex<T>)) == 0;
+}
+
+inline bool fft_verify(const complex<float>* iq, const complex<float>* reference, const size_t N)
+{
+    /* fused multiply-adds round differently than scalar code, so float outputs */
+    /* are compared against the largest reference magnitude (with 2^-16 tolerance) */
+    float max = 0.0f;
+    float err = 0.0f;
+
+    for (size_t n = 0; n < N; ++n) {
+        max = std::max({max, std::fabs(reference[n].real()), std::fabs(reference[n].imag())});
+        err = std::max({err, std::fabs(iq[n].real() - reference[n].real()), std::fabs(iq[n].imag() - reference[n].imag())});
+    }
+
+    return err <= max * (1.0f / 65536.0f);
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FFT_SIMD_ */
@@ -0,0 +1,346 @@
+/**
+ * @file file_source.hpp
+ *
+ * Replay of IQ captures - rtl_sdr style raw files (cu8), 16 bit integer
+ * (cs16) and 32 bit float (cf32) ones, the format being told by the file
+ * extension, or SigMF recordings (.sigmf-meta / .sigmf-data pair) which
+ * also give the sample rate and centre frequency. Files are memory mapped
+ * and read sequentially, cs16 and cf32 samples are requantised to u8 ones
+ * (u8 value b standing for (b - 127) / 128, as front-end sees it), so they
+ * get the ~48 dB dynamic range of 8 bit samples (a warning is printed).
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FILE_SOURCE_HPP_
+#define _FILE_SOURCE_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "iq_source.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define SIGMF_META_SUFFIX ".sigmf-meta"
+#define SIGMF_DATA_SUFFIX ".sigmf-data"
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+enum class iq_format
+{
+    cu8,  /* interleaved uint8_t (I, Q), 127.5 being 0 */
+    cs16, /* interleaved int16_t (I, Q), little endian */
+    cf32, /* interleaved float (I, Q), little endian */
+};
+
+inline std::size_t iq_format_size(iq_format format);
+inline uint8_t iq_u8_from_s16(int16_t v);
+inline bool sigmf_field(const std::string& meta, const char* key, std::string& value);
+
+class file_source : public iq_source
+{
+public:
+    explicit file_source() :
+        m_fd{-1},
+        m_data{nullptr},
+        m_size{0},
+        m_offset{0},
+        m_format{iq_format::cu8},
+        m_sample_rate{0},
+        m_frequency{0}
+    {
+    }
+
+    ~file_source() override
+    {
+        close();
+    }
+
+    file_source(const file_source&) = delete;
+    file_source& operator = (const file_source&) = delete;
+
+    bool open(const char* path)
+    {
+        /* false (errno set) when the file cannot be mapped or its format is not known */
+        std::string data_path(path);
+
+        close();
+
+        if (ends_with(data_path, SIGMF_META_SUFFIX) || ends_with(data_path, SIGMF_DATA_SUFFIX)) {
+            const std::string base = data_path.substr(0, data_path.size() - strlen(SIGMF_DATA_SUFFIX));
+            if (!read_sigmf_meta(base + SIGMF_META_SUFFIX))
+                return false;
+            data_path = base + SIGMF_DATA_SUFFIX;
+        }
+        else
+        if (ends_with(data_path, ".cs16") || ends_with(data_path, ".ci16") || ends_with(data_path, ".sc16"))
+            m_format = iq_format::cs16;
+        else
+        if (ends_with(data_path, ".cf32") || ends_with(data_path, ".fc32") || ends_with(data_path, ".cfile"))
+            m_format = iq_format::cf32;
+        else
+            m_format = iq_format::cu8; /* .cu8, .bin, .raw, ... as written by rtl_sdr */
+
+        m_fd = ::open(data_path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(m_fd, &st) < 0) {
+            close();
+            return false;
+        }
+
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size > 0) {
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+            if (data == MAP_FAILED) {
+                close();
+                return false;
+            }
+            madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const uint8_t*>(data);
+        }
+
+        m_offset = 0;
+
+        return true;
+    }
+
+    void close()
+    {
+        if (m_data)
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+
+        m_fd = -1;
+        m_data = nullptr;
+        m_size = 0;
+        m_offset = 0;
+    }
+
+    std::size_t read(uint8_t* buf, std::size_t size) override
+    {
+        const std::size_t sample_size = iq_format_size(m_format);
+        const std::size_t count = std::min(size / 2, (m_size - m_offset) / sample_size);
+        const uint8_t* src = m_data + m_offset;
+
+        if (count == 0)
+            return 0;
+
+        if (m_format == iq_format::cu8)
+            memcpy(buf, src, count * 2);
+        else
+        if (m_format == iq_format::cs16)
+            for (std::size_t n = 0; n < count * 2; ++n) {
+                int16_t v;
+                memcpy(&v, src + n * sizeof(v), sizeof(v));
+                buf[n] = iq_u8_from_s16(v);
+            }
+        else
+            for (std::size_t n = 0; n < count * 2; ++n) {
+                float v;
+                memcpy(&v, src + n * sizeof(v), sizeof(v));
+                buf[n] = iq_u8_from_f32(v);
+            }
+
+        m_offset += count * sample_size;
+
+        return count * 2;
+    }
+
+    uint32_t sample_rate() const override
+    {
+        return m_sample_rate;
+    }
+
+    uint32_t frequency() const override
+    {
+        return m_frequency;
+    }
+
+    iq_format format() const
+    {
+        return m_format;
+    }
+
+    std::size_t samples() const
+    {
+        return m_size / iq_format_size(m_format);
+    }
+
+private:
+    static bool ends_with(const std::string& str, const char* suffix)
+    {
+        const std::size_t length = strlen(suffix);
+        return (str.size() >= length) && (str.compare(str.size() - length, length, suffix) == 0);
+    }
+
+    bool read_sigmf_meta(const std::string& path)
+    {
+        FILE* fp = fopen(path.c_str(), "r");
+        if (fp == NULL)
+            return false;
+
+        std::string meta;
+        char chunk[4096];
+        std::size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+            meta.append(chunk, n);
+        fclose(fp);
+
+        std::string value;
+        if (!sigmf_field(meta, "core:datatype", value)) {
+            errno = EINVAL;
+            return false;
+        }
+
+        if (value == "cu8")
+            m_format = iq_format::cu8;
+        else
+        if ((value == "ci16_le") || (value == "ci16"))
+            m_format = iq_format::cs16;
+        else
+        if ((value == "cf32_le") || (value == "cf32"))
+            m_format = iq_format::cf32;
+        else {
+            errno = ENOTSUP;
+            return false;
+        }
+
+        if (sigmf_field(meta, "core:sample_rate", value))
+            m_sample_rate = static_cast<uint32_t>(llround(strtod(value.c_str(), nullptr)));
+        if (sigmf_field(meta, "core:frequency", value)) /* of the first capture segment */
+            m_frequency = static_cast<uint32_t>(llround(strtod(value.c_str(), nullptr)));
+
+        return true;
+    }
+
+    int m_fd;
+    const uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_offset; /* in bytes */
+    iq_format m_format;
+    uint32_t m_sample_rate;
+    uint32_t m_frequency;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline std::size_t iq_format_size(iq_format format)
+{
+    /* bytes per (I, Q) sample */
+    switch (format) {
+        case iq_format::cu8:  return 2 * sizeof(uint8_t);
+        case iq_format::cs16: return 2 * sizeof(int16_t);
+        case iq_format::cf32: return 2 * sizeof(float);
+    }
+
+    return 2;
+}
+
+inline const char* iq_format_to_string(iq_format format)
+{
+    switch (format) {
+        case iq_format::cu8:  return "cu8";
+        case iq_format::cs16: return "cs16";
+        case iq_format::cf32: return "cf32";
+    }
+
+    return "unknown";
+}
+
+inline uint8_t iq_u8_from_s16(int16_t v)
+{
+    /* Q15 value rounded to u8 units (1 / 128), saturated */
+    return static_cast<uint8_t>(std::clamp(((static_cast<int>(v) + 128) >> 8) + 127, 0, 255));
+}
+
+inline bool sigmf_field(const std::string& meta, const char* key, std::string& value)
+{
+    /* first "key": value pair of the (json) metadata, quotes stripped - enough for sigmf core fields */
+    const std::string quoted = std::string("\"") + key + "\"";
+    std::size_t pos = meta.find(quoted);
+    if (pos == std::string::npos)
+        return false;
+
+    pos = meta.find(':', pos + quoted.size());
+    if (pos == std::string::npos)
+        return false;
+
+    pos = meta.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos)
+        return false;
+
+    if (meta[pos] == '"') {
+        const std::size_t end = meta.find('"', pos + 1);
+        if (end == std::string::npos)
+            return false;
+        value = meta.substr(pos + 1, end - pos - 1);
+    }
+    else {
+        const std::size_t end = meta.find_first_of(",}] \t\r\n", pos);
+        value = meta.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    }
+
+    return !value.empty();
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FILE_SOURCE_HPP_ */
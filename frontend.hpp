@@ -0,0 +1,585 @@
+/**
+ * @file frontend.hpp
+ *
+ * Fused front-end kernel - raw rtl-sdr u8 (I, Q) bytes are converted,
+ * get their dc component removed and are windowed in a single pass,
+ * straight into the fft input buffer. The dc component is tracked by
+ * a streaming dc blocker, fed once with every new chunk of samples (no
+ * matter how many overlapping or filter bank frames share them later),
+ * kernels only subtract its current estimate.
+ * There are three conversion engines - direct (arithmetic per byte),
+ * table driven (256 entry u8 -> sample type table) and simd ones; all of
+ * them give the same samples (table driven q15 ones may differ by 1 lsb
+ * where (u8 - 127) * 256 saturates). frontend_converter times them on
+ * the actual frame size and uses the fastest one.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _FRONTEND_HPP_
+#define _FRONTEND_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+#include "q15.hpp"
+#include "complex.hpp"
+#include "fft_simd.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define FRONTEND_U8_ZERO 127 /* u8 value seen as 0 */
+#define FRONTEND_DC_BLOCK 16 /* samples (32 bytes) per dc blocker update */
+#define FRONTEND_DC_BLOCKER_SHIFT 10 /* time constant of 2^10 blocks (16384 samples) */
+#define FRONTEND_DC_FRACTION_BITS 16
+#define FRONTEND_BENCHMARK_RUNS 8 /* runs per engine, the fastest one counts */
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+struct frontend_dc
+{
+    long re; /* in Q15 units (1 << 15 is 1.0) */
+    long im;
+};
+
+inline bool frontend_simd_supported();
+
+class frontend_dc_blocker
+{
+    /* single pole dc blocker, y[n] = x[n] - dc, with dc += (x - dc) * 2^-shift */
+    /* updated once per block of FRONTEND_DC_BLOCK samples (with block mean as x), */
+    /* every sample is tracked once, when its chunk arrives, frames get correction() of that time */
+public:
+    explicit frontend_dc_blocker(int shift = FRONTEND_DC_BLOCKER_SHIFT) :
+        m_re{0},
+        m_im{0},
+        m_shift{shift},
+        m_primed{false},
+        m_simd{frontend_simd_supported()}
+    {
+    }
+
+    long re() const /* in Q15 units (1 << 15 is 1.0), rounded - truncation would leave a dc bias of its own */
+    {
+        return (m_re + (1L << (FRONTEND_DC_FRACTION_BITS - 1))) >> FRONTEND_DC_FRACTION_BITS;
+    }
+
+    long im() const
+    {
+        return (m_im + (1L << (FRONTEND_DC_FRACTION_BITS - 1))) >> FRONTEND_DC_FRACTION_BITS;
+    }
+
+    frontend_dc correction() const
+    {
+        return frontend_dc{re(), im()};
+    }
+
+    bool primed() const
+    {
+        return m_primed;
+    }
+
+    void prime(const uint8_t* src, std::size_t N)
+    {
+        /* starts from mean of the very first frame instead of 0 */
+        unsigned long sum_re = 0;
+        unsigned long sum_im = 0;
+
+        for (std::size_t n = 0; n < N; ++n) {
+            sum_re += src[2 * n + 0];
+            sum_im += src[2 * n + 1];
+        }
+
+        m_re = mean(sum_re, N);
+        m_im = mean(sum_im, N);
+        m_primed = true;
+    }
+
+    void track(const uint8_t* src, std::size_t N)
+    {
+        /* N new u8 (I, Q) samples, the first ones ever only prime the blocker (they are not tracked again) */
+        std::size_t n = 0;
+
+        if (N == 0)
+            return;
+
+        if (!m_primed) {
+            prime(src, N);
+            return;
+        }
+
+#if defined(FFT_SIMD_X86)
+        if (m_simd)
+            n = track_avx2(src, N);
+#endif
+
+        for (; n < N; n += FRONTEND_DC_BLOCK) {
+            const std::size_t count = std::min<std::size_t>(FRONTEND_DC_BLOCK, N - n);
+            unsigned long sum_re = 0;
+            unsigned long sum_im = 0;
+            for (std::size_t k = 0; k < count; ++k) {
+                sum_re += src[2 * (n + k) + 0];
+                sum_im += src[2 * (n + k) + 1];
+            }
+            update(sum_re, sum_im, count);
+        }
+    }
+
+    void update(unsigned long sum_re, unsigned long sum_im, std::size_t count)
+    {
+        /* sums are the ones of raw u8 bytes */
+        m_re += (mean(sum_re, count) - m_re) >> m_shift;
+        m_im += (mean(sum_im, count) - m_im) >> m_shift;
+    }
+
+private:
+    static long mean(unsigned long sum, std::size_t count)
+    {
+        const long x = static_cast<long>(sum) * 256 - FRONTEND_U8_ZERO * 256 * static_cast<long>(count);
+        return x * (1L << FRONTEND_DC_FRACTION_BITS) / static_cast<long>(count);
+    }
+
+#if defined(FFT_SIMD_X86)
+    FFT_TARGET_AVX2
+    std::size_t track_avx2(const uint8_t* src, std::size_t N)
+    {
+        /* whole blocks only (32 bytes each), returns number of samples tracked, */
+        /* I and Q bytes are summed separately by vpsadbw, sums are exactly the scalar ones */
+        static_assert(FRONTEND_DC_BLOCK == 16, "one block shall fill one 256-bit register");
+        const __m256i low = _mm256_set1_epi16(0x00ff);
+        const __m256i zero = _mm256_setzero_si256();
+        std::size_t n = 0;
+
+        for (; n + FRONTEND_DC_BLOCK <= N; n += FRONTEND_DC_BLOCK) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * n));
+            const __m256i re = _mm256_sad_epu8(_mm256_and_si256(v, low), zero);
+            const __m256i im = _mm256_sad_epu8(_mm256_srli_epi16(v, 8), zero);
+            const __m256i s = _mm256_add_epi64(_mm256_unpacklo_epi64(re, im), _mm256_unpackhi_epi64(re, im));
+            alignas(16) uint64_t sums[2]; /* (sum_re, sum_im) */
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums),
+                _mm_add_epi64(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+            update(sums[0], sums[1], FRONTEND_DC_BLOCK);
+        }
+
+        return n;
+    }
+#endif
+
+    long m_re; /* Q15 units with FRONTEND_DC_FRACTION_BITS extra fractional bits */
+    long m_im;
+    int m_shift;
+    bool m_primed;
+    bool m_simd; /* block sums by avx2 */
+};
+
+enum class frontend_engine
+{
+    automatic, /* fastest one, as measured by frontend_converter::select() */
+    direct,
+    table,
+    simd,
+};
+
+template<typename T>
+inline T frontend_sample(long v); /* v is given in Q15 units */
+
+template<typename T>
+class frontend_converter
+{
+public:
+    /* simd engine depends on the cpu only (not on fft isa), it shall be checked by has_simd() before asking for it */
+    explicit frontend_converter(frontend_engine engine = frontend_engine::automatic) :
+        m_isa{frontend_simd_supported() ? fft_isa::avx2 : fft_isa::scalar},
+        m_engine{engine},
+        m_table(256)
+    {
+        for (int b = 0; b < 256; ++b)
+            m_table[b] = frontend_sample<T>((b - FRONTEND_U8_ZERO) * 256L);
+    }
+
+    frontend_engine engine() const
+    {
+        return m_engine;
+    }
+
+    bool has_simd() const
+    {
+        return (m_isa == fft_isa::avx2) && (std::is_same<T, fixq15>::value ||
+            std::is_same<T, float>::value || std::is_same<T, q15<int16_t>>::value);
+    }
+
+    const T* table() const /* table[b] is (b - 127) * 256 in Q15 units */
+    {
+        return m_table.data();
+    }
+
+    void convert(complex<T>* iq, const uint8_t* src, const T* window, const size_t N, const frontend_dc dc) const
+    {
+        switch (m_engine) {
+            case frontend_engine::simd:
+                return frontend_u8(iq, src, window, N, dc, m_isa);
+
+            case frontend_engine::table:
+                return frontend_u8_table(iq, src, m_table.data(), window, N, dc);
+
+            default:
+                return frontend_u8(iq, src, window, N, dc);
+        }
+    }
+
+    double measure(frontend_engine engine, const size_t N, const T* window) const /* ns per sample */
+    {
+        /* every engine gets its own timing loop (gcc 12 -O3 ices on an unswitched loop over convert()) */
+        switch (engine) {
+            case frontend_engine::simd:
+                return time(N, [&](complex<T>* iq, const uint8_t* src, const frontend_dc dc){
+                    frontend_u8(iq, src, window, N, dc, m_isa);
+                });
+
+            case frontend_engine::table:
+                return time(N, [&](complex<T>* iq, const uint8_t* src, const frontend_dc dc){
+                    frontend_u8_table(iq, src, m_table.data(), window, N, dc);
+                });
+
+            default:
+                return time(N, [&](complex<T>* iq, const uint8_t* src, const frontend_dc dc){
+                    frontend_u8(iq, src, window, N, dc);
+                });
+        }
+    }
+
+    frontend_engine select(const size_t N, const T* window, double* timings = nullptr)
+    {
+        /* times available engines on N samples frames, timings[] gets ns per sample of direct, table and */
+        /* simd ones (the last one only if has_simd()) */
+        if (m_engine != frontend_engine::automatic)
+            return m_engine;
+
+        const double direct = measure(frontend_engine::direct, N, window);
+        const double table = measure(frontend_engine::table, N, window);
+        const double simd = has_simd() ? measure(frontend_engine::simd, N, window) : 0.0;
+
+        m_engine = (table < direct) ? frontend_engine::table : frontend_engine::direct;
+        if (has_simd() && (simd < std::min(direct, table)))
+            m_engine = frontend_engine::simd;
+
+        if (timings) {
+            timings[0] = direct;
+            timings[1] = table;
+            timings[2] = simd;
+        }
+
+        return m_engine;
+    }
+
+private:
+    template<typename F>
+    static double time(const size_t N, F&& convert)
+    {
+        std::vector<uint8_t> src(2 * N);
+        std::vector<complex<T>> iq(N);
+        uint32_t seed = 1;
+        for (uint8_t& b : src) {
+            seed = seed * 1664525 + 1013904223;
+            b = static_cast<uint8_t>(seed >> 24);
+        }
+
+        const frontend_dc dc{0, 0};
+        convert(iq.data(), src.data(), dc); /* warm up */
+
+        double best = 0.0;
+        for (int run = 0; run < FRONTEND_BENCHMARK_RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            convert(iq.data(), src.data(), dc);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            if ((run == 0) || (elapsed.count() < best))
+                best = elapsed.count();
+        }
+
+        return best / std::max<size_t>(N, 1);
+    }
+
+    fft_isa m_isa;
+    frontend_engine m_engine;
+    std::vector<T> m_table;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<>
+inline fixq15 frontend_sample<fixq15>(long v)
+{
+    return fixq15(v);
+}
+
+template<>
+inline q15<int16_t> frontend_sample<q15<int16_t>>(long v)
+{
+    return q15<int16_t>::saturate(static_cast<int32_t>(std::clamp<long>(v, INT32_MIN, INT32_MAX)));
+}
+
+template<>
+inline q15<int32_t> frontend_sample<q15<int32_t>>(long v)
+{
+    return q15<int32_t>::saturate(v);
+}
+
+template<>
+inline float frontend_sample<float>(long v)
+{
+    return static_cast<float>(v) / Q15;
+}
+
+template<typename T>
+inline void frontend_u8(complex<T>* iq, const uint8_t* src, const T* window, const size_t N, const frontend_dc dc)
+{
+    /* iq[n] = ((src[2n, 2n + 1] - 127) * 256 - dc) * window[n], window may be nullptr (rectangular one) */
+    const long bias_re = FRONTEND_U8_ZERO * 256 + dc.re;
+    const long bias_im = FRONTEND_U8_ZERO * 256 + dc.im;
+
+    for (size_t n = 0; n < N; ++n) {
+        const T re = frontend_sample<T>(src[2 * n + 0] * 256 - bias_re);
+        const T im = frontend_sample<T>(src[2 * n + 1] * 256 - bias_im);
+        if (window)
+            iq[n] = complex<T>(re * window[n], im * window[n]);
+        else
+            iq[n] = complex<T>(re, im);
+    }
+}
+
+template<typename T>
+inline void frontend_u8_table(complex<T>* iq, const uint8_t* src, const T* table, const T* window, const size_t N,
+    const frontend_dc dc)
+{
+    /* as frontend_u8(), but (src - 127) * 256 comes from the table and dc is subtracted in T */
+    const T dc_re = frontend_sample<T>(dc.re);
+    const T dc_im = frontend_sample<T>(dc.im);
+
+    for (size_t n = 0; n < N; ++n) {
+        const T re = table[src[2 * n + 0]] - dc_re;
+        const T im = table[src[2 * n + 1]] - dc_im;
+        if (window)
+            iq[n] = complex<T>(re * window[n], im * window[n]);
+        else
+            iq[n] = complex<T>(re, im);
+    }
+}
+
+#if defined(FFT_SIMD_X86)
+
+FFT_TARGET_AVX2
+inline void frontend_u8_avx2(complex<fixq15>* iq, const uint8_t* src, const fixq15* window, const size_t N,
+    const frontend_dc dc)
+{
+    /* two samples (4 bytes -> 4 x int64) per step, window product truncated as fixq15 one */
+    const __m256i bias = _mm256_setr_epi64x(
+        FRONTEND_U8_ZERO * 256 + dc.re, FRONTEND_U8_ZERO * 256 + dc.im,
+        FRONTEND_U8_ZERO * 256 + dc.re, FRONTEND_U8_ZERO * 256 + dc.im);
+    size_t n = 0;
+
+    for (; n + 2 <= N; n += 2) {
+        int32_t pair;
+        memcpy(&pair, src + 2 * n, sizeof(pair));
+        __m256i v = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(pair));
+        v = _mm256_sub_epi64(_mm256_slli_epi64(v, 8), bias);
+        if (window) {
+            /* (w0, w0, w1, w1) */
+            const __m256i w = _mm256_permute4x64_epi64(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(window + n))),
+                _MM_SHUFFLE(1, 1, 0, 0));
+            v = fft_div_q15_avx2(_mm256_mul_epi32(v, w));
+        }
+        fft_store_avx2(iq + n, v);
+    }
+
+    if (n < N)
+        frontend_u8(iq + n, src + 2 * n, window ? window + n : nullptr, N - n, dc);
+}
+
+FFT_TARGET_FMA
+inline void frontend_u8_fma(complex<float>* iq, const uint8_t* src, const float* window, const size_t N,
+    const frontend_dc dc)
+{
+    /* four samples (8 bytes -> 8 x float) per step */
+    const __m256 scale = _mm256_set1_ps(256.0f / Q15);
+    const __m256i duplicate = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const float bias_re = static_cast<float>(FRONTEND_U8_ZERO * 256 + dc.re) / Q15;
+    const float bias_im = static_cast<float>(FRONTEND_U8_ZERO * 256 + dc.im) / Q15;
+    const __m256 bias = _mm256_setr_ps(bias_re, bias_im, bias_re, bias_im, bias_re, bias_im, bias_re, bias_im);
+    size_t n = 0;
+
+    for (; n + 4 <= N; n += 4) {
+        const __m128i quad = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 2 * n));
+        __m256 v = _mm256_fmsub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(quad)), scale, bias);
+        if (window) {
+            /* (w0, w0, w1, w1, w2, w2, w3, w3) */
+            const __m256 w = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(window + n)), duplicate);
+            v = _mm256_mul_ps(v, w);
+        }
+        fft_store_fma(iq + n, v);
+    }
+
+    if (n < N)
+        frontend_u8(iq + n, src + 2 * n, window ? window + n : nullptr, N - n, dc);
+}
+
+FFT_TARGET_AVX2
+inline void frontend_u8_avx2(complex<q15<int16_t>>* iq, const uint8_t* src, const q15<int16_t>* window, const size_t N,
+    const frontend_dc dc)
+{
+    /* eight samples (16 bytes -> 16 x int16, vpmovzxbw) per step, (b - 128) * 256 is exact in int16, */
+    /* so saturating subtraction of the rest of the bias (dc - 256) saturates as the scalar kernel does, */
+    /* window product is rounded as q15 one (vpmulhrsw) */
+    const __m256i half = _mm256_set1_epi16(0x80);
+    const uint16_t bias_re = static_cast<uint16_t>(std::clamp<long>(dc.re - 256, INT16_MIN, INT16_MAX));
+    const uint16_t bias_im = static_cast<uint16_t>(std::clamp<long>(dc.im - 256, INT16_MIN, INT16_MAX));
+    const __m256i bias = _mm256_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(bias_im) << 16) | bias_re));
+    size_t n = 0;
+
+    for (; n + 8 <= N; n += 8) {
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * n)));
+        v = _mm256_subs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(v, half), 8), bias);
+        if (window) {
+            /* (w0, w0, w1, w1, ..., w7, w7) */
+            const __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(window + n)));
+            v = _mm256_mulhrs_epi16(v, _mm256_or_si256(w, _mm256_slli_epi32(w, 16)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(iq + n), v);
+    }
+
+    if (n < N)
+        frontend_u8(iq + n, src + 2 * n, window ? window + n : nullptr, N - n, dc);
+}
+
+#endif /* FFT_SIMD_X86 */
+
+inline void frontend_u8(complex<fixq15>* iq, const uint8_t* src, const fixq15* window, const size_t N,
+    const frontend_dc dc, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if (isa == fft_isa::avx2)
+        return frontend_u8_avx2(iq, src, window, N, dc);
+#endif
+    (void)isa;
+    frontend_u8(iq, src, window, N, dc);
+}
+
+inline void frontend_u8(complex<float>* iq, const uint8_t* src, const float* window, const size_t N,
+    const frontend_dc dc, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if (isa == fft_isa::avx2)
+        return frontend_u8_fma(iq, src, window, N, dc);
+#endif
+    (void)isa;
+    frontend_u8(iq, src, window, N, dc);
+}
+
+inline void frontend_u8(complex<q15<int16_t>>* iq, const uint8_t* src, const q15<int16_t>* window, const size_t N,
+    const frontend_dc dc, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if (isa == fft_isa::avx2)
+        return frontend_u8_avx2(iq, src, window, N, dc);
+#endif
+    (void)isa;
+    frontend_u8(iq, src, window, N, dc);
+}
+
+template<typename T>
+inline void frontend_u8(complex<T>* iq, const uint8_t* src, const T* window, const size_t N,
+    const frontend_dc dc, const fft_isa isa)
+{
+    /* simd kernels are there for complex<fixq15>, complex<q15<int16_t>> and complex<float> only, */
+    /* other types use scalar ones */
+    (void)isa;
+    frontend_u8(iq, src, window, N, dc);
+}
+
+inline bool frontend_simd_supported()
+{
+    /* front-end simd kernels are avx2 ones (fma for float samples) */
+#if defined(FFT_SIMD_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+inline const char* frontend_engine_to_string(frontend_engine engine)
+{
+    switch (engine) {
+        case frontend_engine::automatic: return "auto";
+        case frontend_engine::direct:    return "direct";
+        case frontend_engine::table:     return "table";
+        case frontend_engine::simd:      return "simd";
+    }
+
+    return "unknown";
+}
+
+inline bool frontend_engine_from_string(const char* str, frontend_engine& engine)
+{
+    static const frontend_engine engines[] = {frontend_engine::automatic, frontend_engine::direct,
+        frontend_engine::table, frontend_engine::simd};
+
+    for (frontend_engine e : engines)
+        if (strcmp(str, frontend_engine_to_string(e)) == 0) {
+            engine = e;
+            return true;
+        }
+
+    return false;
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _FRONTEND_HPP_ */
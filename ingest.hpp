@@ -0,0 +1,207 @@
+/**
+ * @file ingest.hpp
+ *
+ * Pool of sample blocks between an asynchronous capture thread (e.g.
+ * rtlsdr_read_async() callbacks) and the pipeline producer.
+ * Capture side takes a free block, fills it and submits it, producer side
+ * gets filled blocks by reference and releases them back to the pool once
+ * they are consumed. Capture side never blocks - when no block is free
+ * the data is dropped (and counted), and the next submitted block is
+ * marked as following a gap, so frames are not taken across it.
+ * This is not zero-copy: rtlsdr_read_async() resubmits its usb buffer as
+ * soon as the callback returns, so every usb buffer is copied into a pool
+ * block once (submit(data, length)). From then on the block changes hands
+ * by pointer (both queues are single producer, single consumer ringbuffers
+ * of block pointers) and the producer converts frames straight from it
+ * (sample_history::attach()), keeping only what frames spanning block
+ * boundaries need - there is no second, staging copy.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _INGEST_HPP_
+#define _INGEST_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "ringbuffer.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+struct ingest_block
+{
+    uint8_t* data;
+    std::size_t length; /* valid bytes */
+    bool gap; /* some data has been dropped right before this block */
+};
+
+class ingest_pool
+{
+public:
+    /* 'blocks' blocks of 'block_size' bytes each, all of them free at start */
+    explicit ingest_pool(std::size_t blocks, std::size_t block_size) :
+        m_block_size{block_size},
+        m_memory(blocks * block_size),
+        m_blocks(blocks),
+        m_free{blocks, RINGBUFFER_RD_NONBLOCKING_WR_NONBLOCKING},
+        m_filled{blocks, RINGBUFFER_RD_BLOCKING_WR_NONBLOCKING},
+        m_dropped{0},
+        m_gap{false},
+        m_spare{nullptr}
+    {
+        for (std::size_t n = 0; n < blocks; ++n) {
+            m_blocks[n] = ingest_block{m_memory.data() + n * block_size, 0, false};
+            m_free.write(&m_blocks[n]);
+        }
+    }
+
+    std::size_t block_size() const
+    {
+        return m_block_size;
+    }
+
+    std::size_t dropped() const /* bytes dropped for the lack of free blocks */
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    /* capture side, nullptr when there is no free block */
+    ingest_block* acquire()
+    {
+        ingest_block* block = m_spare;
+
+        if (block != nullptr) {
+            m_spare = nullptr;
+            return block;
+        }
+
+        if (m_free.read(block) != 1)
+            return nullptr;
+
+        return block;
+    }
+
+    bool submit(ingest_block* block, std::size_t length)
+    {
+        /* block goes back to the free ones (the next acquire() takes it) and its data is dropped */
+        /* if it cannot be queued */
+        block->length = std::min(length, m_block_size);
+        block->gap = m_gap;
+
+        if (m_filled.write(block) != 1) {
+            m_spare = block; /* m_free is written by the producer side only */
+            drop(length);
+            return false;
+        }
+
+        m_gap = false;
+
+        return true;
+    }
+
+    bool submit(const uint8_t* data, std::size_t length)
+    {
+        /* copies data into a free block, drops it if there is none */
+        ingest_block* block = acquire();
+        if (block == nullptr) {
+            drop(length);
+            return false;
+        }
+
+        memcpy(block->data, data, std::min(length, m_block_size));
+
+        return submit(block, length);
+    }
+
+    void drop(std::size_t length)
+    {
+        m_dropped.fetch_add(length, std::memory_order_relaxed);
+        m_gap = true;
+    }
+
+    /* producer side, blocks until there is a filled block, nullptr when cancelled */
+    ingest_block* next()
+    {
+        ingest_block* block;
+
+        if (m_filled.read(block) != 1)
+            return nullptr;
+
+        return block;
+    }
+
+    void release(ingest_block* block)
+    {
+        m_free.write(block);
+    }
+
+    void cancel() /* wakes up the producer side */
+    {
+        m_filled.cancel(ringbuffer_role::CONSUMER);
+    }
+
+private:
+    std::size_t m_block_size;
+    std::vector<uint8_t> m_memory;
+    std::vector<ingest_block> m_blocks;
+    ringbuffer<ingest_block*> m_free;
+    ringbuffer<ingest_block*> m_filled;
+    std::atomic<std::size_t> m_dropped;
+    bool m_gap; /* capture side only */
+    ingest_block* m_spare; /* capture side only, free block which could not be submitted */
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _INGEST_HPP_ */
@@ -0,0 +1,255 @@
+/**
+ * @file integrate.hpp
+ *
+ * Power spectrum integration (Welch averaging) - |X[k]|^2 of consecutive,
+ * possibly overlapping frames is accumulated over M frames, so only one
+ * averaged spectrum per M frames has to be emitted.
+ * Powers of all sample types are accumulated in double, 1.0 being |X|^2
+ * of a full scale (1.0) bin - fixed point bins of large transforms grow up
+ * to 2^15 * N, their squares do not fit in 64 bits above 2^16 points.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _INTEGRATE_HPP_
+#define _INTEGRATE_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+#include "complex.hpp"
+#include "fft_simd.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define INTEGRATE_Q15_SCALE (1.0 / (static_cast<double>(Q15) * Q15))
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+class integrator
+{
+public:
+    using accumulator_type = double;
+
+    /* N bins, averaged spectrum is ready after every 'frames' frames */
+    explicit integrator(std::size_t N, std::size_t frames) :
+        m_frames{std::max<std::size_t>(1, frames)},
+        m_count{0},
+        m_power(N)
+    {
+    }
+
+    std::size_t size() const
+    {
+        return m_power.size();
+    }
+
+    std::size_t frames() const
+    {
+        return m_frames;
+    }
+
+    std::size_t count() const /* frames accumulated so far */
+    {
+        return m_count;
+    }
+
+    bool ready() const
+    {
+        return m_count >= m_frames;
+    }
+
+    const accumulator_type* power() const /* sums of |X[k]|^2 over count() frames */
+    {
+        return m_power.data();
+    }
+
+    accumulator_type* power()
+    {
+        return m_power.data();
+    }
+
+    void added()
+    {
+        ++m_count;
+    }
+
+    void reset()
+    {
+        std::fill(m_power.begin(), m_power.end(), accumulator_type{});
+        m_count = 0;
+    }
+
+private:
+    std::size_t m_frames;
+    std::size_t m_count;
+    std::vector<accumulator_type> m_power;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline void integrate_power(double* power, const complex<T>* iq, const size_t N, const int exponent)
+{
+    /* power[k] += |iq[k] * 2^exponent|^2, Q15 values squared in double do not overflow at any size */
+    const double scale = std::ldexp(INTEGRATE_Q15_SCALE, 2 * exponent);
+    for (size_t k = 0; k < N; ++k) {
+        const double re = static_cast<double>(iq[k].real().value());
+        const double im = static_cast<double>(iq[k].imag().value());
+        power[k] += (re * re + im * im) * scale;
+    }
+}
+
+inline void integrate_power(double* power, const complex<float>* iq, const size_t N, const int exponent)
+{
+    /* floating point samples have no block exponent */
+    (void)exponent;
+    for (size_t k = 0; k < N; ++k)
+        power[k] += static_cast<double>(iq[k].real()) * iq[k].real() + static_cast<double>(iq[k].imag()) * iq[k].imag();
+}
+
+inline bool integrate_simd_fits(const complex<fixq15>* iq, const size_t N)
+{
+    /* simd kernel takes low 32 bits of real and imaginary parts only - u8 derived bins grow */
+    /* up to 2^15 * N, which is 2^31 already at 2^16 points (and more for filter bank frames), */
+    /* so every frame is checked, the ones which do not fit go to the scalar kernel */
+    for (size_t k = 0; k < N; ++k) {
+        const int64_t re = iq[k].real().value();
+        const int64_t im = iq[k].imag().value();
+        if ((re < INT32_MIN) || (re > INT32_MAX) || (im < INT32_MIN) || (im > INT32_MAX))
+            return false;
+    }
+
+    return true;
+}
+
+#if defined(FFT_SIMD_X86)
+
+FFT_TARGET_AVX2
+inline void integrate_power_avx2(double* power, const complex<fixq15>* iq, const size_t N, const int exponent)
+{
+    /* four bins per step, real and imaginary parts shall fit in 32 bits (integrate_simd_fits()), */
+    /* so they are taken as int32 and converted to double exactly */
+    const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m256d scale = _mm256_set1_pd(std::ldexp(INTEGRATE_Q15_SCALE, 2 * exponent));
+    size_t k = 0;
+
+    for (; k + 4 <= N; k += 4) {
+        const __m256d a = _mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(fft_load_avx2(iq + k), low)));
+        const __m256d b = _mm256_cvtepi32_pd(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(fft_load_avx2(iq + k + 2), low)));
+        /* (p0, p2, p1, p3) -> (p0, p1, p2, p3) */
+        const __m256d h = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        const __m256d p = _mm256_permute4x64_pd(h, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256d acc = _mm256_loadu_pd(power + k);
+        _mm256_storeu_pd(power + k, _mm256_add_pd(acc, _mm256_mul_pd(p, scale)));
+    }
+
+    integrate_power(power + k, iq + k, N - k, exponent);
+}
+
+FFT_TARGET_FMA
+inline void integrate_power_fma(double* power, const complex<float>* iq, const size_t N)
+{
+    /* four bins per step, squares are summed in float and accumulated in double */
+    size_t k = 0;
+
+    for (; k + 4 <= N; k += 4) {
+        const __m256 v = fft_load_fma(iq + k);
+        const __m256 sq = _mm256_mul_ps(v, v);
+        /* (re0^2 + im0^2, re1^2 + im1^2, ...) in lanes 0, 1, 4, 5 -> (p0, p1, p2, p3) */
+        const __m256 h = _mm256_hadd_ps(sq, sq);
+        const __m128 p = _mm_castpd_ps(_mm256_castpd256_pd128(
+            _mm256_permute4x64_pd(_mm256_castps_pd(h), _MM_SHUFFLE(2, 0, 2, 0))));
+        __m256d acc = _mm256_loadu_pd(power + k);
+        _mm256_storeu_pd(power + k, _mm256_add_pd(acc, _mm256_cvtps_pd(p)));
+    }
+
+    integrate_power(power + k, iq + k, N - k, 0);
+}
+
+#endif /* FFT_SIMD_X86 */
+
+inline void integrate(integrator<fixq15>& acc, const complex<fixq15>* iq, const int exponent, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && integrate_simd_fits(iq, acc.size())) {
+        integrate_power_avx2(acc.power(), iq, acc.size(), exponent);
+        return acc.added();
+    }
+#endif
+    (void)isa;
+    integrate_power(acc.power(), iq, acc.size(), exponent);
+    acc.added();
+}
+
+inline void integrate(integrator<float>& acc, const complex<float>* iq, const int exponent, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if (isa == fft_isa::avx2) {
+        integrate_power_fma(acc.power(), iq, acc.size());
+        return acc.added();
+    }
+#endif
+    (void)isa;
+    integrate_power(acc.power(), iq, acc.size(), exponent);
+    acc.added();
+}
+
+template<typename T>
+inline void integrate(integrator<T>& acc, const complex<T>* iq, const int exponent, const fft_isa isa)
+{
+    /* simd kernels are there for complex<fixq15> and complex<float> only, other types use scalar ones */
+    (void)isa;
+    integrate_power(acc.power(), iq, acc.size(), exponent);
+    acc.added();
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _INTEGRATE_HPP_ */
@@ -0,0 +1,126 @@
+/**
+ * @file iq_source.hpp
+ *
+ * Sample sources other than an rtlsdr device (captures, generators) as seen
+ * by the pipeline producer - they deliver interleaved u8 (I, Q) samples,
+ * the same ones rtlsdr_read_sync() does, so everything behind the producer
+ * stays the same. Offline sources deliver samples as fast as they are
+ * asked for, iq_throttle paces them to a given sample rate.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _IQ_SOURCE_HPP_
+#define _IQ_SOURCE_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+class iq_source
+{
+public:
+    virtual ~iq_source() = default;
+
+    /* up to size bytes (whole samples only) of interleaved u8 (I, Q) samples, 0 at the end of input */
+    virtual std::size_t read(uint8_t* buf, std::size_t size) = 0;
+
+    virtual uint32_t sample_rate() const /* 0 - not known to the source */
+    {
+        return 0;
+    }
+
+    virtual uint32_t frequency() const /* 0 - not known to the source */
+    {
+        return 0;
+    }
+};
+
+class iq_throttle
+{
+public:
+    explicit iq_throttle(double sample_rate) :
+        m_sample_rate{sample_rate},
+        m_start{std::chrono::steady_clock::now()},
+        m_samples{0}
+    {
+    }
+
+    void wait(std::size_t samples)
+    {
+        /* sleeps until 'samples' more samples are due, deadlines do not drift */
+        m_samples += samples;
+        const std::chrono::duration<double> due(m_samples / m_sample_rate);
+        std::this_thread::sleep_until(m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+    }
+
+private:
+    double m_sample_rate;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_samples;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline uint8_t iq_u8_from_f32(float v)
+{
+    /* 1.0 being full scale, rounded to u8 units (1 / 128), saturated */
+    if (!(v == v)) /* nan */
+        return 127;
+
+    return static_cast<uint8_t>(std::clamp<long>(lrintf(std::clamp(v, -2.0f, 2.0f) * 128.0f) + 127, 0, 255));
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _IQ_SOURCE_HPP_ */
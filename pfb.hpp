@@ -0,0 +1,163 @@
+/**
+ * @file pfb.hpp
+ *
+ * Polyphase filter bank front end of the fft (weighted overlap-add form).
+ * P * N samples are weighted by a windowed sinc prototype filter (cut-off
+ * at 1/N) and folded into N points, y[n] = sum x[n + p * N] * h[n + p * N],
+ * before the N point fft. Branch n of the bank is the prototype decimated
+ * by N (P taps per branch), which gives much flatter and sharper bin
+ * responses than a window of N samples only.
+ * Consecutive frames are N (critically sampled) or N / 2 (2x oversampled)
+ * samples apart, folded points are rotated by frame start (modulo N),
+ * so bins keep their phase reference from frame to frame.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _PFB_HPP_
+#define _PFB_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <vector>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "complex.hpp"
+#include "frontend.hpp"
+#include "window.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define PFB_TAPS_MAX 16
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+class pfb_plan
+{
+public:
+    /* N branches (fft size, power of 2) with 'taps' taps each, prototype windowed by given window */
+    explicit pfb_plan(std::size_t N, std::size_t taps, bool oversampled,
+        window_type window, double beta = WINDOW_KAISER_BETA_DEFAULT) :
+        m_size{N},
+        m_taps{taps},
+        m_hop{oversampled ? N / 2 : N},
+        m_coefficients(N * taps)
+    {
+        const std::size_t M = N * taps;
+
+        for (std::size_t m = 0; m < M; ++m) {
+            const double x = (static_cast<double>(m) - M / 2.0) / N;
+            const double sinc = (m * 2 == M) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            m_coefficients[m] = to_coefficient(sinc * window_value(window, m, M, beta));
+        }
+    }
+
+    std::size_t size() const /* N - number of branches (and fft size) */
+    {
+        return m_size;
+    }
+
+    std::size_t taps() const /* P - taps per branch */
+    {
+        return m_taps;
+    }
+
+    std::size_t length() const /* P * N - samples per frame */
+    {
+        return m_coefficients.size();
+    }
+
+    std::size_t hop() const /* samples between starts of consecutive frames */
+    {
+        return m_hop;
+    }
+
+    const T* coefficients() const /* h[n + p * N], branch n takes every N-th one */
+    {
+        return m_coefficients.data();
+    }
+
+private:
+    static T to_coefficient(double h)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return static_cast<T>(h);
+        else
+            return frontend_sample<T>(lround(h * Q15));
+    }
+
+    std::size_t m_size;
+    std::size_t m_taps;
+    std::size_t m_hop;
+    std::vector<T> m_coefficients;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline void pfb_fold(complex<T>* iq, const complex<T>* weighted, const size_t N, const size_t taps, const size_t rotation)
+{
+    /* iq[(n + rotation) % N] = sum weighted[n + p * N], weighted holds taps * N already weighted samples */
+    for (size_t n = 0; n < N; ++n) {
+        complex<T> sum = weighted[n];
+        for (size_t p = 1; p < taps; ++p)
+            sum += weighted[n + p * N];
+        iq[(n + rotation) & (N - 1)] = sum;
+    }
+}
+
+template<typename T>
+inline void pfb_u8(complex<T>* iq, complex<T>* scratch, const uint8_t* src, const pfb_plan<T>& plan,
+    const size_t rotation, const frontend_dc dc, const frontend_converter<T>& frontend)
+{
+    /* src holds plan.length() u8 (I, Q) samples, scratch shall have room for plan.length() samples, */
+    /* weighting is done by the front-end converter, i.e. prototype filter is its window */
+    frontend.convert(scratch, src, plan.coefficients(), plan.length(), dc);
+    pfb_fold(iq, scratch, plan.size(), plan.taps(), rotation);
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _PFB_HPP_ */
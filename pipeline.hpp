@@ -5,6 +5,13 @@
  * Each pipeline stage is responsible for processing one pipeline buffer
  * and once processing of such buffer is finished,
  * buffer is passed to the next pipeline stage for further processing and so on.
+ * Buffers may be taken from the pipeline's own pool (see get_buffer()),
+ * they go back to it (instead of being freed) when the last stage releases
+ * them, so once the pool has warmed up no allocations are made at all.
+ * A stage whose function returns false passes an empty buffer (end of
+ * stream marker) to the next one, so a finite source drains the whole
+ * pipeline. Queues drop buffers when full by default, blocking ones
+ * (see queue_flags) make stages wait for the slower ones instead.
  *
  * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
  *
@@ -25,6 +32,7 @@
  * system header files
 \*===========================================================================*/
 #include <memory>
+#include <vector>
 #include <functional>
 #include <thread>
 #include <atomic>
@@ -60,24 +68,101 @@ public:
     struct buffer
     {
         virtual ~buffer() = default;
+
+        buffer* m_next = nullptr; /* link of the pool's free list */
+    };
+
+    /* Lock-free stack of free buffers (any thread puts, only one thread gets) */
+    class buffer_pool
+    {
+    public:
+        explicit buffer_pool() :
+            m_head{nullptr}
+        {
+        }
+
+        ~buffer_pool()
+        {
+            while (buffer* b = get())
+                delete b;
+        }
+
+        buffer_pool(const buffer_pool&) = delete;
+        buffer_pool& operator = (const buffer_pool&) = delete;
+
+        void put(buffer* b)
+        {
+            b->m_next = m_head.load(std::memory_order_relaxed);
+            while (!m_head.compare_exchange_weak(b->m_next, b, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        buffer* get() /* nullptr when empty, single consumer only (so no aba problem) */
+        {
+            buffer* b = m_head.load(std::memory_order_acquire);
+            while (b && !m_head.compare_exchange_weak(b, b->m_next, std::memory_order_acquire, std::memory_order_acquire));
+            return b;
+        }
+
+    private:
+        alignas(CACHELINE_SIZE) std::atomic<buffer*> m_head;
+    };
+
+    /* Returns pooled buffers to their pool, deletes other ones */
+    struct buffer_deleter
+    {
+        buffer_deleter(buffer_pool* pool = nullptr) :
+            m_pool{pool}
+        {
+        }
+
+        template<typename U>
+        buffer_deleter(const std::default_delete<U>&) :
+            m_pool{nullptr}
+        {
+        }
+
+        void operator()(buffer* b) const
+        {
+            if (m_pool)
+                m_pool->put(b);
+            else
+                delete b;
+        }
+
+        buffer_pool* m_pool;
     };
 
-    using buffer_uptr = std::unique_ptr<buffer>;
+    using buffer_uptr = std::unique_ptr<buffer, buffer_deleter>;
+
+    template<typename B>
+    using typed_buffer_uptr = std::unique_ptr<B, buffer_deleter>;
 
     using stage_function = std::function<bool(iringbuffer<buffer_uptr>* irb, oringbuffer<buffer_uptr>* orb)>;
 
     template<std::size_t N>
-    explicit pipeline(stage_function (&f)[N], std::size_t queue_capacity) :
-       m_size{N},
-       m_stages{std::make_unique<std::unique_ptr<stage_exec_env>[]>(N)},
+    explicit pipeline(stage_function (&f)[N], std::size_t queue_capacity,
+                      std::bitset<RINGBUFFER_NONBLOCKING_FLAGS_MAX> queue_flags = RINGBUFFER_RD_BLOCKING_WR_NONBLOCKING) :
+       pipeline{std::vector<stage_function>(f, f + N), queue_capacity, queue_flags}
+    {
+    }
+
+    /* for pipelines whose stages are known at runtime only */
+    explicit pipeline(const std::vector<stage_function>& f, std::size_t queue_capacity,
+                      std::bitset<RINGBUFFER_NONBLOCKING_FLAGS_MAX> queue_flags = RINGBUFFER_RD_BLOCKING_WR_NONBLOCKING) :
+       m_pool{},
+       m_allocated{0},
+       m_size{f.size()},
+       m_stages{std::make_unique<std::unique_ptr<stage_exec_env>[]>(f.size())},
        m_ringbuffers{},
        m_running{false}
     {
+        const std::size_t N = f.size();
+
         if (N > 1) {
             m_ringbuffers = std::make_unique<std::unique_ptr<ringbuffer<buffer_uptr>>[]>(N - 1);
             for (std::size_t n = 0; n < (N - 1); ++n)
                 m_ringbuffers[n] = std::make_unique<ringbuffer<buffer_uptr>>(
-                    queue_capacity, RINGBUFFER_RD_BLOCKING_WR_NONBLOCKING);
+                    queue_capacity, queue_flags);
         }
 
         for (std::size_t n = 0; n < N; ++n) {
@@ -100,6 +185,34 @@ public:
         }
     }
 
+    /* All buffers taken from the pool shall be of the same type B (and size), */
+    /* a new one is allocated only when there is no free one (it joins the pool when released) */
+    template<typename B, typename... Args>
+    typed_buffer_uptr<B> get_buffer(Args&&... args)
+    {
+        buffer* b = m_pool.get();
+        if (b == nullptr) {
+            b = new B(std::forward<Args>(args)...);
+            m_allocated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return typed_buffer_uptr<B>{static_cast<B*>(b), buffer_deleter{&m_pool}};
+    }
+
+    template<typename B, typename... Args>
+    void reserve_buffers(std::size_t count, Args&&... args)
+    {
+        for (std::size_t n = 0; n < count; ++n) {
+            m_pool.put(new B(args...));
+            m_allocated.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t allocated_buffers() const
+    {
+        return m_allocated.load(std::memory_order_relaxed);
+    }
+
     void start()
     {
         m_running = true;
@@ -111,8 +224,10 @@ public:
     {
         m_running = false;
         if (m_size > 1) {
-            for (std::size_t n = 0; n < (m_size - 1); ++n)
+            for (std::size_t n = 0; n < (m_size - 1); ++n) {
                 m_ringbuffers[n]->cancel(ymn::ringbuffer_role::CONSUMER);
+                m_ringbuffers[n]->cancel(ymn::ringbuffer_role::PRODUCER);
+            }
         }
     }
 
@@ -158,6 +273,11 @@ private:
         {
             m_semaphore.wait();
             while ((m_pipeline.m_running) && (m_function(m_irb, m_orb) == true));
+            if (m_orb)
+                /* end of stream, next stage reads nullptr - unlike frames it is never dropped, */
+                /* on a full non-blocking queue it waits for the next stage to make room */
+                while ((m_orb->write(buffer_uptr{}) != 1) && (m_pipeline.m_running))
+                    std::this_thread::yield();
         }
 
         const pipeline& m_pipeline;
@@ -168,6 +288,8 @@ private:
         std::thread m_thread;
     };
 
+    buffer_pool m_pool; /* declared first, so it outlives buffers held by ringbuffers */
+    std::atomic<std::size_t> m_allocated;
     std::size_t m_size;
     std::unique_ptr<std::unique_ptr<stage_exec_env>[]> m_stages;
     std::unique_ptr<std::unique_ptr<ringbuffer<buffer_uptr>>[]> m_ringbuffers;
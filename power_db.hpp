@@ -0,0 +1,215 @@
+/**
+ * @file power_db.hpp
+ *
+ * Power spectrum in dB - |X[k]|^2 of a transformed frame converted to a dense
+ * array of dB values (0 dB being |1.0|^2), for whatever consumes spectra.
+ * Integrated and sliding dft powers are printed through power_db_from_power().
+ * log10() is replaced by a fast log2 approximation, log2(2^e * (1 + x)) =
+ * e + x * p(x), p being a degree 3 polynomial fitted (near minimax) over
+ * x in [0, 1). Its absolute error is below 1.03e-4 (i.e. 3.1e-4 dB),
+ * rounding of the float arithmetic keeps the total error below 0.001 dB
+ * (down to the POWER_DB_FLOOR, below which everything is clamped).
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _POWER_DB_HPP_
+#define _POWER_DB_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+#include "complex.hpp"
+#include "fft_simd.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define POWER_DB_FLOOR 1e-20f /* -200 dB */
+#define POWER_DB_PER_LOG2 3.010299956639812f /* 10 * log10(2) */
+/* u8 derived samples stay within 2^15, so up to 2^16 bins fft outputs fit in 32 bits */
+#define POWER_DB_SIMD_SIZE_MAX (64 * 1024)
+
+/* log2(1 + x) ~ x * (C1 + x * (C2 + x * (C3 + x * C4))), x in [0, 1), */
+/* absolute error below 1.03e-4, i.e. 3.1e-4 dB once scaled by POWER_DB_PER_LOG2 */
+#define POWER_DB_LOG2_C1 1.43901691f
+#define POWER_DB_LOG2_C2 -0.679961924f
+#define POWER_DB_LOG2_C3 0.325633736f
+#define POWER_DB_LOG2_C4 -0.0847921108f
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline float power_db_log2(float p)
+{
+    /* p shall be a normal, positive number */
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+
+    const float e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    const uint32_t mantissa = (bits & 0x007fffff) | 0x3f800000;
+    float x;
+    memcpy(&x, &mantissa, sizeof(x));
+    x -= 1.0f;
+
+    return e + x * (POWER_DB_LOG2_C1 + x * (POWER_DB_LOG2_C2 + x * (POWER_DB_LOG2_C3 + x * POWER_DB_LOG2_C4)));
+}
+
+inline float power_db_from_power(float p, int exponent)
+{
+    /* block floating point exponent scales the power by 2^(2 * exponent) */
+    return POWER_DB_PER_LOG2 * (power_db_log2(std::max(p, POWER_DB_FLOOR)) + 2 * exponent);
+}
+
+template<typename T>
+inline void power_db(float* db, const complex<T>* iq, const size_t N, const int exponent)
+{
+    for (size_t k = 0; k < N; ++k) {
+        const float re = static_cast<float>(iq[k].real().value()) * (1.0f / Q15);
+        const float im = static_cast<float>(iq[k].imag().value()) * (1.0f / Q15);
+        db[k] = power_db_from_power(re * re + im * im, exponent);
+    }
+}
+
+inline void power_db(float* db, const complex<float>* iq, const size_t N, const int exponent)
+{
+    for (size_t k = 0; k < N; ++k)
+        db[k] = power_db_from_power(iq[k].real() * iq[k].real() + iq[k].imag() * iq[k].imag(), exponent);
+}
+
+#if defined(FFT_SIMD_X86)
+
+FFT_TARGET_FMA
+inline __m128 power_db_fma(__m128 p, const int exponent)
+{
+    /* four powers at once, as power_db_from_power() */
+    const __m128i bits = _mm_castps_si128(_mm_max_ps(p, _mm_set1_ps(POWER_DB_FLOOR)));
+    const __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127 - 2 * exponent));
+    const __m128 x = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+        _mm_set1_epi32(0x3f800000))), _mm_set1_ps(1.0f));
+
+    __m128 poly = _mm_fmadd_ps(x, _mm_set1_ps(POWER_DB_LOG2_C4), _mm_set1_ps(POWER_DB_LOG2_C3));
+    poly = _mm_fmadd_ps(x, poly, _mm_set1_ps(POWER_DB_LOG2_C2));
+    poly = _mm_fmadd_ps(x, poly, _mm_set1_ps(POWER_DB_LOG2_C1));
+
+    return _mm_mul_ps(_mm_fmadd_ps(x, poly, _mm_cvtepi32_ps(e)), _mm_set1_ps(POWER_DB_PER_LOG2));
+}
+
+FFT_TARGET_FMA
+inline __m128 power_db_sum_fma(__m256 v)
+{
+    /* (re0, im0, ..., re3, im3) -> (re0^2 + im0^2, ..., re3^2 + im3^2) */
+    const __m256 sq = _mm256_mul_ps(v, v);
+    const __m256 h = _mm256_hadd_ps(sq, sq);
+    return _mm_castpd_ps(_mm256_castpd256_pd128(
+        _mm256_permute4x64_pd(_mm256_castps_pd(h), _MM_SHUFFLE(2, 0, 2, 0))));
+}
+
+FFT_TARGET_FMA
+inline void power_db_fma(float* db, const complex<fixq15>* iq, const size_t N, const int exponent)
+{
+    /* four bins per step, real and imaginary parts are expected to fit in 32 bits (as for simd fft) */
+    const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256 scale = _mm256_set1_ps(1.0f / Q15);
+    size_t k = 0;
+
+    for (; k + 4 <= N; k += 4) {
+        const __m256i a = _mm256_permutevar8x32_epi32(fft_load_avx2(iq + k), low);
+        const __m256i b = _mm256_permutevar8x32_epi32(fft_load_avx2(iq + k + 2), low);
+        const __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_permute2x128_si256(a, b, 0x20)), scale);
+        _mm_storeu_ps(db + k, power_db_fma(power_db_sum_fma(v), exponent));
+    }
+
+    power_db(db + k, iq + k, N - k, exponent);
+}
+
+FFT_TARGET_FMA
+inline void power_db_fma(float* db, const complex<float>* iq, const size_t N)
+{
+    size_t k = 0;
+
+    for (; k + 4 <= N; k += 4)
+        _mm_storeu_ps(db + k, power_db_fma(power_db_sum_fma(fft_load_fma(iq + k)), 0));
+
+    power_db(db + k, iq + k, N - k, 0);
+}
+
+#endif /* FFT_SIMD_X86 */
+
+inline void power_db(float* db, const complex<fixq15>* iq, const size_t N, const int exponent, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if ((isa == fft_isa::avx2) && (N <= POWER_DB_SIMD_SIZE_MAX))
+        return power_db_fma(db, iq, N, exponent);
+#endif
+    (void)isa;
+    power_db(db, iq, N, exponent);
+}
+
+inline void power_db(float* db, const complex<float>* iq, const size_t N, const int exponent, const fft_isa isa)
+{
+#if defined(FFT_SIMD_X86)
+    if (isa == fft_isa::avx2)
+        return power_db_fma(db, iq, N);
+#endif
+    (void)isa;
+    power_db(db, iq, N, exponent);
+}
+
+template<typename T>
+inline void power_db(float* db, const complex<T>* iq, const size_t N, const int exponent, const fft_isa isa)
+{
+    /* simd kernels are there for complex<fixq15> and complex<float> only, other types use scalar ones */
+    (void)isa;
+    power_db(db, iq, N, exponent);
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _POWER_DB_HPP_ */
@@ -0,0 +1,138 @@
+/**
+ * @file q15.hpp
+ *
+ * Compact fixed point with 15 fractional bits, templated on storage width.
+ * Sums and products are computed in a twice as wide intermediate type
+ * and saturated back to the storage one. Multiplication rounds
+ * ((a * b + 2^14) >> 15) as pmulhrsw does, so simd kernels can use it
+ * directly (apart from -1 * -1, which pmulhrsw wraps and q15 saturates).
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _Q15_HPP_
+#define _Q15_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstdint>
+#include <limits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename S>
+struct q15_traits; /* intermediate (twice as wide) type for a given storage one */
+
+template<>
+struct q15_traits<int16_t>
+{
+    using intermediate_type = int32_t;
+};
+
+template<>
+struct q15_traits<int32_t>
+{
+    using intermediate_type = int64_t;
+};
+
+template<typename S>
+class q15 /* fixed point with 15 fractional bits stored in S */
+{
+public:
+    using storage_type = S;
+    using intermediate_type = typename q15_traits<S>::intermediate_type;
+
+    constexpr q15() : m_value{} {}
+    constexpr q15(S v) : m_value{v} {}
+    constexpr operator S () const {return m_value;}
+    constexpr S value() const {return m_value;}
+
+    static constexpr q15 saturate(intermediate_type v)
+    {
+        return static_cast<S>(
+            v > std::numeric_limits<S>::max() ? std::numeric_limits<S>::max() :
+            v < std::numeric_limits<S>::min() ? std::numeric_limits<S>::min() : v);
+    }
+
+private:
+    S m_value;
+};
+
+template<typename S>
+constexpr q15<S> operator + (q15<S> lhs, q15<S> rhs)
+{
+    using I = typename q15<S>::intermediate_type;
+    return q15<S>::saturate(I(lhs.value()) + I(rhs.value()));
+}
+
+template<typename S>
+constexpr q15<S> operator - (q15<S> lhs, q15<S> rhs)
+{
+    using I = typename q15<S>::intermediate_type;
+    return q15<S>::saturate(I(lhs.value()) - I(rhs.value()));
+}
+
+template<typename S>
+constexpr q15<S> operator * (q15<S> lhs, q15<S> rhs)
+{
+    using I = typename q15<S>::intermediate_type;
+    return q15<S>::saturate((I(lhs.value()) * I(rhs.value()) + (I(1) << 14)) >> 15);
+}
+
+template<typename S>
+constexpr q15<S> operator / (q15<S> lhs, q15<S> rhs)
+{
+    using I = typename q15<S>::intermediate_type;
+    return q15<S>::saturate(I(lhs.value()) * Q15 / I(rhs.value()));
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _Q15_HPP_ */
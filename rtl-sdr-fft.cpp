@@ -24,8 +24,12 @@
 #include <getopt.h>
 #include <signal.h>
 #include <math.h>
+#include <errno.h>
 
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <type_traits>
 #include <chrono>
 #include <thread>
 
@@ -37,17 +41,41 @@
 #include "strtointeger.hpp"
 #include "power_of_two.hpp"
 #include "fixq15.hpp"
+#include "q15.hpp"
 #include "complex.hpp"
 #include "fft.hpp"
+#include "fft_simd.hpp"
+#include "fft_fourstep.hpp"
+#include "fft_batch.hpp"
+#include "fft_bfp.hpp"
+#include "frontend.hpp"
+#include "window.hpp"
+#include "integrate.hpp"
+#include "sample_history.hpp"
+#include "sliding_dft.hpp"
+#include "pfb.hpp"
+#include "zoom.hpp"
+#include "power_db.hpp"
+#include "ingest.hpp"
+#include "iq_source.hpp"
+#include "file_source.hpp"
+#include "synth_source.hpp"
+#include "aligned_allocator.hpp"
 #include "pipeline.hpp"
 #include "ringbuffer.hpp"
 
 /*===========================================================================*\
  * preprocessor #define constants and macros
 \*===========================================================================*/
-#define FFT_SIZE_MAX    (8 * 1024)
-#define IQBUF_SIZE      (FFT_SIZE_MAX * 2)
+#define FFT_SIZE_MAX        (4 * 1024 * 1024) /* fixq15 bins (up to 2^15 * N) and their integrated powers fit */
+#define FFT_SIZE_FOURSTEP   (128 * 1024) /* four-step fft is used from this size on */
+#define IQBUF_SIZE_MIN      (16 * 1024)
+#define FFT_BATCH_LANES     (4) /* frames transformed together in --fft-batch mode */
+#define PRINT_FFT_SPECTRA   (0) /* per frame dB spectra are printed (-I prints averaged ones regardless) */
 #define IDLE_LOOPS_NUM  (1)
+#define ASYNC_BUFFERS_MAX          (64)
+#define ASYNC_BUFFER_SIZE_DEFAULT  (16 * 16384) /* as in librtlsdr */
+#define ASYNC_POOL_BLOCKS_PER_BUFFER (4) /* blocks the producer may lag behind capture by, per usb buffer */
 
 /*===========================================================================*\
  * local type definitions
@@ -57,27 +85,77 @@ struct buffer : public ymn::pipeline::buffer
 {
     explicit buffer() :
         ymn::pipeline::buffer{},
-        vector()
+        vector(),
+        exponent{0},
+        sequence{0}
     {
     }
 
     explicit buffer(std::size_t size) :
         ymn::pipeline::buffer{},
-        vector(size)
+        vector(size),
+        exponent{0},
+        sequence{0}
     {
     }
 
-    std::vector<T> vector;
+    std::vector<T, ymn::aligned_allocator<T>> vector; /* cache line aligned */
+    int exponent; /* block floating point exponent, samples are vector[n] * 2^exponent */
+    uint64_t sequence; /* frame number, frames following each other without a gap have consecutive ones */
 };
 
+#if defined(IQ_Q15)
+using iq_t = ymn::complex<ymn::q15<int16_t>>; /* 4 bytes per sample instead of 16 */
+#else
 using iq_t = ymn::complex<ymn::fixq15>;
-using iq_buffer_uptr = std::unique_ptr<buffer<iq_t>>;
+#endif
+using iq_f32_t = ymn::complex<float>;
 
-iq_buffer_uptr to_iq_buffer_uptr(ymn::pipeline::buffer_uptr&& p)
+template<typename IQ>
+using iq_buffer_uptr = ymn::pipeline::typed_buffer_uptr<buffer<IQ>>;
+
+template<typename IQ>
+iq_buffer_uptr<IQ> to_iq_buffer_uptr(ymn::pipeline::buffer_uptr&& p)
 {
-    return iq_buffer_uptr{static_cast<buffer<iq_t>*>(p.release())};
+    /* deleter goes along, so pooled buffers still find their way back to the pool */
+    const ymn::pipeline::buffer_deleter deleter = p.get_deleter();
+    return iq_buffer_uptr<IQ>{static_cast<buffer<IQ>*>(p.release()), deleter};
 }
 
+enum class sample_type_e
+{
+    q15, /* iq_t - fixed point */
+    f32, /* iq_f32_t */
+};
+
+struct options
+{
+    uint32_t frequency;
+    uint32_t bandwidth;
+    int fft_size;
+    ymn::fft_isa fft_isa;
+    bool fft_verify;
+    bool fft_stockham;
+    bool fft_batch;
+    bool fft_bfp;
+    ymn::window_type window;
+    double window_beta; /* kaiser window only */
+    int integrate; /* frames averaged per emitted power spectrum, 0 - raw spectra */
+    int overlap; /* overlap of consecutive frames, in percent */
+    std::vector<std::size_t> sdft_bins; /* dc-centred bins (as printed) tracked by sliding dft */
+    bool sdft_alarm; /* report threshold crossings instead of bin powers */
+    double sdft_threshold; /* in dB */
+    int pfb_taps; /* taps per polyphase filter bank branch, 0 - no filter bank */
+    bool pfb_oversample; /* 2x oversampled filter bank (frames are N / 2 apart) */
+    uint32_t zoom_center; /* frequency the zoomed slice is centred at */
+    uint32_t zoom_span; /* width of the zoomed slice, 0 - no zoom */
+    int async_buffers; /* usb transfer buffers of rtlsdr_read_async(), 0 - rtlsdr_read_sync() is used */
+    uint32_t async_buffer_size;
+    ymn::frontend_engine frontend; /* u8 -> sample type conversion engine */
+    bool input_unthrottled; /* offline sources only, as fast as the pipeline goes */
+    FILE* fp;
+};
+
 /*===========================================================================*\
  * global object definitions
 \*===========================================================================*/
@@ -88,22 +166,33 @@ iq_buffer_uptr to_iq_buffer_uptr(ymn::pipeline::buffer_uptr&& p)
 static void print_usage(const char* progname);
 static void signal_handler(int signum);
 static void install_signal_handler(void);
-static void remove_dc(iq_t* iqbuf, const std::size_t N);
-static void print_fft(FILE *fp, uint32_t fc, uint32_t bw, iq_t* iqbuf, const std::size_t N);
+static void async_callback(unsigned char* buf, uint32_t len, void* ctx);
+static void open_device(uint32_t frequency, uint32_t bandwidth);
+template<typename IQ>
+static void run_pipeline(const options& opts);
+static void print_fft(FILE *fp, uint32_t fc, uint32_t bw, const float* db, const std::size_t N);
+template<typename A>
+static void print_power(FILE *fp, uint32_t fc, uint32_t bw, const A* power, const std::size_t N, std::size_t frames);
+template<typename T>
+static void print_sdft(FILE *fp, uint32_t fc, uint32_t bw, const ymn::sliding_dft<T>& sdft);
+static bool parse_bins(const char* str, std::vector<std::size_t>& bins);
 static int verbose_device_search(const char *s);
 
 /*===========================================================================*\
  * local object definitions
 \*===========================================================================*/
 static rtlsdr_dev_t *rtlsdr_device = NULL;
-static uint8_t iqbuf_u8[IQBUF_SIZE];
-static std::unique_ptr<iq_t[]> e_2pi_i;
+static std::unique_ptr<ymn::sample_history<uint8_t>> iqbuf_u8; /* interleaved (I, Q) bytes */
+static std::size_t iqbuf_u8_size;
 static std::unique_ptr<ymn::pipeline> pipeline;
+static std::unique_ptr<ymn::ingest_pool> ingest_pool; /* async ingest only */
+static std::unique_ptr<ymn::iq_source> iq_source; /* instead of rtlsdr device (--input) */
 
 /*===========================================================================*\
  * inline function definitions
 \*===========================================================================*/
-static inline iq_buffer_uptr get_iq_buffer_uptr(ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb)
+template<typename IQ>
+static inline iq_buffer_uptr<IQ> get_iq_buffer_uptr(ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb)
 {
     ymn::pipeline::buffer_uptr buf_uptr;
 
@@ -111,20 +200,62 @@ static inline iq_buffer_uptr get_iq_buffer_uptr(ymn::iringbuffer<ymn::pipeline::
     if (read_status != 1)
         return nullptr;
 
-    return to_iq_buffer_uptr(std::move(buf_uptr));
+    return to_iq_buffer_uptr<IQ>(std::move(buf_uptr));
+}
+
+template<typename IQ>
+static inline void put_iq_buffer_uptr(ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb, iq_buffer_uptr<IQ>&& iqbuf_uptr)
+{
+    long write_status = orb->write(std::move(iqbuf_uptr));
+    if (write_status != 1) {
+       fprintf(stderr, "%s: orb->write() failed\n", __PRETTY_FUNCTION__);
+       fprintf(stderr, "%s\n", orb->to_string().c_str());
+    }
+}
+
+/* v is given in Q15 units (1 << 15 is 1.0) */
+template<typename T>
+static inline T to_value(long v);
+
+template<>
+inline ymn::fixq15 to_value<ymn::fixq15>(long v)
+{
+    return ymn::fixq15(v);
+}
+
+template<>
+inline ymn::q15<int16_t> to_value<ymn::q15<int16_t>>(long v)
+{
+    /* saturates (e.g. 1.0 becomes 32767 / 32768) */
+    return ymn::q15<int16_t>::saturate(static_cast<int32_t>(std::clamp<long>(v, INT32_MIN, INT32_MAX)));
+}
+
+template<>
+inline float to_value<float>(long v)
+{
+    return static_cast<float>(v) / Q15;
 }
 
-inline void generate_e_2pi_i(iq_t* e, const std::size_t N)
+template<typename IQ>
+inline void generate_e_2pi_i(IQ* e, const std::size_t N)
 {
+    using T = typename IQ::value_type;
+
     for (std::size_t i = 0; i < N; ++i) {
         double x = 2.0 * M_PI * i / N;
-        e[i].real(static_cast<ymn::fixq15>(round(Q15 * cos(x))));
-        e[i].imag(static_cast<ymn::fixq15>(round(Q15 * sin(x))));
+        if constexpr (std::is_floating_point<T>::value) {
+            e[i].real(static_cast<T>(cos(x)));
+            e[i].imag(static_cast<T>(sin(x)));
+        }
+        else {
+            e[i].real(to_value<T>(lround(Q15 * cos(x))));
+            e[i].imag(to_value<T>(lround(Q15 * sin(x))));
+        }
     }
 }
 
-template<std::size_t N>
-inline void generate_e_2pi_i(iq_t (&e)[N])
+template<typename IQ, std::size_t N>
+inline void generate_e_2pi_i(IQ (&e)[N])
 {
     static_assert(ymn::is_power_of_two(N), "N must be power of 2");
     generate_e_2pi_i(e, N);
@@ -135,12 +266,33 @@ inline void generate_e_2pi_i(iq_t (&e)[N])
 \*===========================================================================*/
 int main(int argc, char *argv[])
 {
-    int status;
     uint32_t frequency = 0;
     uint32_t bandwidth = 2000000;
+    bool bandwidth_set = false;
     int fft_size = 2048;
+    ymn::fft_isa fft_isa = ymn::fft_isa::scalar;
+    bool fft_verify = false;
+    bool fft_stockham = false;
+    bool fft_batch = false;
+    bool fft_bfp = false;
+    sample_type_e sample_type = sample_type_e::q15;
+    ymn::window_type window = ymn::window_type::rectangular;
+    double window_beta = WINDOW_KAISER_BETA_DEFAULT;
+    int integrate = 0;
+    int overlap = 0;
+    std::vector<std::size_t> sdft_bins;
+    bool sdft_alarm = false;
+    double sdft_threshold = 0.0;
+    int pfb_taps = 0;
+    bool pfb_oversample = false;
+    uint32_t zoom_center = 0;
+    uint32_t zoom_span = 0;
+    int async_buffers = 0;
+    uint32_t async_buffer_size = ASYNC_BUFFER_SIZE_DEFAULT;
+    ymn::frontend_engine frontend = ymn::frontend_engine::automatic;
+    const char* input = nullptr;
+    bool input_unthrottled = false;
     FILE* fp;
-    int dev_index;
 
     install_signal_handler();
 
@@ -148,11 +300,31 @@ int main(int argc, char *argv[])
         {"frequency", required_argument, 0, 'f'},
         {"bandwidth", required_argument, 0, 'b'},
         {"fft-size",  required_argument, 0, 'n'},
+        {"fft-isa",   required_argument, 0, 'i'},
+        {"fft-verify",      no_argument, 0, 'v'},
+        {"fft-stockham",    no_argument, 0, 's'},
+        {"fft-batch",       no_argument, 0, 'B'},
+        {"fft-bfp",         no_argument, 0, 'F'},
+        {"sample-type", required_argument, 0, 't'},
+        {"window",    required_argument, 0, 'w'},
+        {"integrate", required_argument, 0, 'I'},
+        {"overlap",   required_argument, 0, 'O'},
+        {"sdft-bins", required_argument, 0, 'S'},
+        {"sdft-threshold", required_argument, 0, 'T'},
+        {"pfb",       required_argument, 0, 'P'},
+        {"pfb-oversample",  no_argument, 0, 'X'},
+        {"zoom-center", required_argument, 0, 'z'},
+        {"zoom-span", required_argument, 0, 'Z'},
+        {"async-buffers", required_argument, 0, 'A'},
+        {"async-buffer-size", required_argument, 0, 'a'},
+        {"frontend",  required_argument, 0, 'E'},
+        {"input",     required_argument, 0, 'r'},
+        {"unthrottled",     no_argument, 0, 'U'},
         {0, 0, 0, 0}
     };
 
     for (;;) {
-        int c = getopt_long(argc, argv, "f:b:n:", long_options, 0);
+        int c = getopt_long(argc, argv, "f:b:n:i:vsBFt:w:I:O:S:T:P:Xz:Z:A:a:E:r:U", long_options, 0);
         if (c == -1)
             break;
 
@@ -169,6 +341,7 @@ int main(int argc, char *argv[])
                     fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
                     exit(EXIT_FAILURE);
                 }
+                bandwidth_set = true;
                 break;
 
             case 'n':
@@ -178,6 +351,134 @@ int main(int argc, char *argv[])
                 }
                 break;
 
+            case 'i':
+                if (!ymn::fft_isa_from_string(optarg, fft_isa)) {
+                    fprintf(stderr, "Unknown fft isa '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'v':
+                fft_verify = true;
+                break;
+
+            case 's':
+                fft_stockham = true;
+                break;
+
+            case 'B':
+                fft_batch = true;
+                break;
+
+            case 'F':
+                fft_bfp = true;
+                break;
+
+            case 't':
+                if (strcmp(optarg, "q15") == 0)
+                    sample_type = sample_type_e::q15;
+                else
+                if (strcmp(optarg, "f32") == 0)
+                    sample_type = sample_type_e::f32;
+                else {
+                    fprintf(stderr, "Unknown sample type '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'w':
+                if (!ymn::window_from_string(optarg, window, window_beta)) {
+                    fprintf(stderr, "Unknown window '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'I':
+                if (ymn::strtointeger(optarg, integrate) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'O':
+                if (ymn::strtointeger(optarg, overlap) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'S':
+                if (!parse_bins(optarg, sdft_bins)) {
+                    fprintf(stderr, "Cannot convert '%s' to list of bins\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'T': {
+                char* end;
+                sdft_threshold = strtod(optarg, &end);
+                if ((end == optarg) || (*end != '\0')) {
+                    fprintf(stderr, "Cannot convert '%s' to number\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                sdft_alarm = true;
+                break;
+            }
+
+            case 'P':
+                if (ymn::strtointeger(optarg, pfb_taps) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'X':
+                pfb_oversample = true;
+                break;
+
+            case 'z':
+                if (ymn::strtointeger(optarg, zoom_center) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'Z':
+                if (ymn::strtointeger(optarg, zoom_span) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'A':
+                if (ymn::strtointeger(optarg, async_buffers) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'a':
+                if (ymn::strtointeger(optarg, async_buffer_size) != ymn::strtointeger_conversion_status_e::success) {
+                    fprintf(stderr, "Cannot convert '%s' to integer\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'E':
+                if (!ymn::frontend_engine_from_string(optarg, frontend)) {
+                    fprintf(stderr, "Unknown front-end engine '%s'\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'r':
+                input = optarg;
+                break;
+
+            case 'U':
+                input_unthrottled = true;
+                break;
+
             default:
                 /* do nothing */
                 break;
@@ -194,6 +495,38 @@ int main(int argc, char *argv[])
     else
         fp = stdout;
 
+    if (input && (strncmp(input, SYNTH_PREFIX, strlen(SYNTH_PREFIX)) == 0)) {
+        ymn::synth_config config;
+        if (!ymn::synth_parse(input, config)) {
+            fprintf(stderr, "Cannot parse synthetic source '%s'\n", input);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "Generating %zu tones, %zu chirps, %zu bursts and %.1f dBFS noise (seed %llu)\n",
+            config.tones.size(), config.chirps.size(), config.bursts.size(), config.noise,
+            static_cast<unsigned long long>(config.seed));
+        iq_source = std::make_unique<ymn::synth_source>(config, bandwidth);
+    }
+    else
+    if (input) {
+        std::unique_ptr<ymn::file_source> source = std::make_unique<ymn::file_source>();
+        if (!source->open(input)) {
+            fprintf(stderr, "Cannot open input '%s' (%s)\n", input, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "Reading %zu %s samples from '%s'\n",
+            source->samples(), ymn::iq_format_to_string(source->format()), input);
+        if (source->format() != ymn::iq_format::cu8)
+            fprintf(stderr, "%s samples are requantised to u8, which limits their dynamic range to ~48 dB\n",
+                ymn::iq_format_to_string(source->format()));
+        iq_source = std::move(source);
+
+        /* recording's own metadata (sigmf) unless given explicitly */
+        if ((iq_source->sample_rate() > 0) && !bandwidth_set)
+            bandwidth = iq_source->sample_rate();
+        if ((iq_source->frequency() > 0) && (frequency == 0))
+            frequency = iq_source->frequency();
+    }
+
     if (frequency == 0) {
         print_usage(argv[0]);
         exit(EXIT_FAILURE);
@@ -210,6 +543,105 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
+    /* (fixq15 simd kernels are not capped by size, they check every frame against overflow of their */
+    /* 32-bit lane products and leave the ones which could overflow to scalar kernels, see fft_simd_fits()) */
+    if ((fft_size >= FFT_SIZE_FOURSTEP) &&
+        ((fft_isa != ymn::fft_isa::scalar) || fft_verify || fft_stockham || fft_batch || fft_bfp)) {
+        fprintf(stderr, "fft_size (%u) is done by scalar four-step fft, which has no -i, -v, -s, -B nor -F variants "
+            "(they are there up to %u)\n", fft_size, FFT_SIZE_FOURSTEP / 2);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((fft_size >= FFT_SIZE_FOURSTEP) && (sample_type == sample_type_e::q15) &&
+        ymn::fft_bfp_traits<iq_t::value_type>::required) {
+        fprintf(stderr, "fft_size (%u) is done by four-step fft, which has no block floating point variant "
+            "q15 samples need (they go up to %u, -t f32 ones have no such limit)\n", fft_size, FFT_SIZE_FOURSTEP / 2);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((overlap < 0) || (overlap > 90)) {
+        fprintf(stderr, "Overlap shall be within 0 - 90 percent\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (std::size_t bin : sdft_bins)
+        if (bin >= static_cast<std::size_t>(fft_size)) {
+            fprintf(stderr, "Sliding dft bin (%zu) is out of range (fft_size is %d)\n", bin, fft_size);
+            exit(EXIT_FAILURE);
+        }
+
+    if (!sdft_bins.empty() && ((window != ymn::window_type::rectangular) || (overlap != 0))) {
+        fprintf(stderr, "Sliding dft needs contiguous, unwindowed samples (rectangular window, no overlap)\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((pfb_taps < 0) || (pfb_taps > PFB_TAPS_MAX)) {
+        fprintf(stderr, "Polyphase filter bank taps shall be within 1 - %d\n", PFB_TAPS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((pfb_taps > 0) && ((overlap != 0) || !sdft_bins.empty())) {
+        fprintf(stderr, "Polyphase filter bank sets its own frame hop (no overlap) and cannot feed sliding dft\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (zoom_center == 0)
+        zoom_center = frequency;
+
+    if ((zoom_span > 0) && ((zoom_span > bandwidth / 2) ||
+        (std::abs(static_cast<int64_t>(zoom_center) - frequency) + zoom_span / 2 > bandwidth / 2))) {
+        fprintf(stderr, "Zoomed slice (%u Hz wide at %u Hz) shall be within the captured band and at most half of it\n",
+            zoom_span, zoom_center);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((zoom_span > 0) && (pfb_taps > 0)) {
+        fprintf(stderr, "Zoom fft and polyphase filter bank cannot be used together\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((async_buffers < 0) || (async_buffers > ASYNC_BUFFERS_MAX)) {
+        fprintf(stderr, "Number of async buffers shall be within 1 - %d\n", ASYNC_BUFFERS_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((async_buffer_size == 0) || (async_buffer_size % 512)) {
+        fprintf(stderr, "Async buffer size (%u) shall be a multiple of 512 bytes\n", async_buffer_size);
+        exit(EXIT_FAILURE);
+    }
+
+    if (iq_source && (async_buffers > 0)) {
+        fprintf(stderr, "Async ingest is for rtlsdr devices only, not for --input ones\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (!iq_source)
+        open_device(frequency, bandwidth);
+
+    const options opts{frequency, bandwidth, fft_size, fft_isa, fft_verify, fft_stockham, fft_batch, fft_bfp,
+        window, window_beta, integrate, overlap, sdft_bins, sdft_alarm, sdft_threshold,
+        pfb_taps, pfb_oversample, zoom_center, zoom_span, async_buffers, async_buffer_size, frontend,
+        input_unthrottled, fp};
+
+    if (sample_type == sample_type_e::f32)
+        run_pipeline<iq_f32_t>(opts);
+    else
+        run_pipeline<iq_t>(opts);
+
+    if (rtlsdr_device)
+        rtlsdr_close(rtlsdr_device);
+
+    if (fp != stdout)
+        fclose(fp);
+
+    return 0;
+}
+
+static void open_device(uint32_t frequency, uint32_t bandwidth)
+{
+    int status;
+    int dev_index;
+
     dev_index = verbose_device_search("0");
     if (dev_index < 0)
         exit(EXIT_FAILURE);
@@ -256,9 +688,308 @@ int main(int argc, char *argv[])
     fprintf(stderr, " - done\n");
 
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+/*===========================================================================*\
+ * local function definitions
+\*===========================================================================*/
+static void print_usage(const char* progname)
+{
+    fprintf(stdout, "usage: %s -f <frequency> [-b <bandwidth>] [-n <fft_size>] [-i <fft isa>] [-v] [-s] [-B] [-F] [-t <sample type>] [-w <window>] [-I <frames>] [-O <overlap>] [-S <bins>] [-T <threshold>] [-P <taps>] [-X] [-z <frequency>] [-Z <span>] [-A <buffers>] [-a <size>] [-E <engine>] [-r <input>] [-U] [<filename>]\n", progname);
+    fprintf(stdout, " options:\n");
+    fprintf(stdout, "  -f <frequency>  --frequency=<frequency> : center frequency to tune to\n");
+    fprintf(stdout, "  -b <bandwidth>  --bandwidth=<bandwidth> : bandwidth to be scanned (default: 2 MHz)\n");
+    fprintf(stdout, "  -n <fft size>   --fft-size=<fft size>   : fft size (default: 2048, scalar four-step fft from 131072 on)\n");
+    fprintf(stdout, "  -i <fft isa>    --fft-isa=<fft isa>     : scalar, sse4.1, avx2 or auto (default: scalar)\n");
+    fprintf(stdout, "  -v              --fft-verify            : check simd fft output against scalar one\n");
+    fprintf(stdout, "  -s              --fft-stockham          : out-of-place auto-sort fft (no re-ordering passes)\n");
+    fprintf(stdout, "  -B              --fft-batch             : transform %d frames at once (pays off for small fft sizes)\n", FFT_BATCH_LANES);
+    fprintf(stdout, "  -F              --fft-bfp               : block floating point fft (scaled per stage) for fixq15 samples\n");
+    fprintf(stdout, "                                            (16-bit q15 ones of IQ_Q15 builds always use it, tones between\n");
+    fprintf(stdout, "                                            bins get 46-52 dB snr at 2k points, 41-46 dB at 8k)\n");
+    fprintf(stdout, "  -t <type>       --sample-type=<type>    : q15 (fixed point) or f32 (float) samples (default: q15)\n");
+    fprintf(stdout, "  -w <window>     --window=<window>       : rectangular, hann, hamming, blackman-harris, flat-top\n");
+    fprintf(stdout, "                                            or kaiser[:beta] (default: rectangular, beta: %.1f)\n", WINDOW_KAISER_BETA_DEFAULT);
+    fprintf(stdout, "  -I <frames>     --integrate=<frames>    : print power spectrum averaged over that many frames\n");
+    fprintf(stdout, "  -O <overlap>    --overlap=<overlap>     : overlap of consecutive frames in percent, 0 - 90 (default: 0)\n");
+    fprintf(stdout, "  -S <bins>       --sdft-bins=<bins>      : comma separated bins (as printed) updated with every sample\n");
+    fprintf(stdout, "                                            by sliding dft (needs rectangular window and no overlap),\n");
+    fprintf(stdout, "                                            samples come in whole reads, so updates lag by up to\n");
+    fprintf(stdout, "                                            max(%d, n) samples (max(-a size / 2, n) with -A)\n", IQBUF_SIZE_MIN / 2);
+    fprintf(stdout, "  -T <threshold>  --sdft-threshold=<dB>   : report sliding dft bins crossing that power instead of\n");
+    fprintf(stdout, "                                            printing them once per frame\n");
+    fprintf(stdout, "  -P <taps>       --pfb=<taps>            : polyphase filter bank with that many taps per branch, 1 - %d\n", PFB_TAPS_MAX);
+    fprintf(stdout, "                                            (prototype filter windowed by -w window)\n");
+    fprintf(stdout, "  -X              --pfb-oversample        : 2x oversampled polyphase filter bank\n");
+    fprintf(stdout, "  -z <frequency>  --zoom-center=<frequency> : center of the zoomed slice (default: -f frequency)\n");
+    fprintf(stdout, "  -Z <span>       --zoom-span=<span>      : mix that wide slice to baseband and decimate it by 2^k\n");
+    fprintf(stdout, "                                            (down to %d x span) before the fft, up to %d times\n", ZOOM_SPAN_OVERSAMPLING, ZOOM_DECIMATION_MAX);
+    fprintf(stdout, "  -A <buffers>    --async-buffers=<buffers> : capture with rtlsdr_read_async() using that many usb\n");
+    fprintf(stdout, "                                            buffers, 1 - %d (default: 0, rtlsdr_read_sync() is used)\n", ASYNC_BUFFERS_MAX);
+    fprintf(stdout, "  -a <size>       --async-buffer-size=<size> : size of a usb buffer, multiple of 512 (default: %d)\n", ASYNC_BUFFER_SIZE_DEFAULT);
+    fprintf(stdout, "  -E <engine>     --frontend=<engine>     : u8 samples conversion - direct, table, simd or auto\n");
+    fprintf(stdout, "                                            (default: auto, the fastest one on this cpu)\n");
+    fprintf(stdout, "  -r <input>      --input=<input>         : read samples from a capture instead of rtlsdr device -\n");
+    fprintf(stdout, "                                            .cu8 (rtl_sdr), .cs16, .cf32 or sigmf recording, or generate\n");
+    fprintf(stdout, "                                            them - synth[:tones=<Hz>[@<dBFS>][/...],chirps=<from>:<to>:<s>\n");
+    fprintf(stdout, "                                            [@<dBFS>][/...],bursts=<Hz>:<on s>:<s>[@<dBFS>][/...],\n");
+    fprintf(stdout, "                                            noise=<dBFS>,seed=<n>,samples=<n>] (offsets from -f)\n");
+    fprintf(stdout, "  -U              --unthrottled           : feed --input samples as fast as possible (default: at -b rate)\n");
+    fprintf(stdout, "  <filename>                              : print output values to this file (default: stdout)\n");
+}
+
+static void signal_handler(int signum)
+{
+    fprintf(stderr, "caught signal %d, terminating ...\n", signum);
+    if (pipeline != nullptr)
+        pipeline->stop();
+    if (ingest_pool != nullptr) {
+        rtlsdr_cancel_async(rtlsdr_device);
+        ingest_pool->cancel();
+    }
+    fprintf(stderr, "done\n");
+}
+
+static void install_signal_handler(void)
+{
+    struct sigaction sigact;
+
+    sigact.sa_handler = signal_handler;
+    sigemptyset(&sigact.sa_mask);
+    sigact.sa_flags = 0;
+
+    sigaction(SIGINT, &sigact, NULL);
+    sigaction(SIGTERM, &sigact, NULL);
+    sigaction(SIGQUIT, &sigact, NULL);
+    sigaction(SIGPIPE, &sigact, NULL);
+}
 
-    e_2pi_i = std::make_unique<iq_t[]>(fft_size);
-    generate_e_2pi_i(e_2pi_i.get(), fft_size);
+static void async_callback(unsigned char* buf, uint32_t len, void* ctx)
+{
+    /* usb buffer is resubmitted as soon as we return, so it is copied into a pool block - the only */
+    /* copy of the samples (or they are dropped when the producer lags behind by the whole pool) */
+    static_cast<ymn::ingest_pool*>(ctx)->submit(buf, len);
+}
+
+template<typename IQ>
+static void run_pipeline(const options& opts)
+{
+    using T = typename IQ::value_type;
+    const int fft_size = opts.fft_size;
+    ymn::fft_isa fft_isa = opts.fft_isa;
+    bool fft_bfp = opts.fft_bfp;
+    std::unique_ptr<ymn::fft_plan<T>> fft_plan;
+    std::unique_ptr<ymn::fft_fourstep_plan<T>> fft_fourstep_plan;
+    std::unique_ptr<ymn::fft_batch_plan<T, FFT_BATCH_LANES>> fft_batch_plan;
+    std::unique_ptr<ymn::sliding_dft<T>> sliding_dft;
+    std::vector<bool> sdft_alarms(opts.sdft_bins.size());
+    unsigned long sdft_samples = 0;
+    uint64_t sdft_sequence = 0; /* of the next frame expected by sliding dft */
+
+    {
+        std::unique_ptr<IQ[]> e_2pi_i = std::make_unique<IQ[]>(fft_size);
+        generate_e_2pi_i(e_2pi_i.get(), fft_size);
+        if (!opts.sdft_bins.empty()) {
+            std::vector<std::size_t> bins; /* natural order, i.e. no fftshift */
+            for (std::size_t bin : opts.sdft_bins)
+                bins.push_back((bin + fft_size / 2) % fft_size);
+            sliding_dft = std::make_unique<ymn::sliding_dft<T>>(e_2pi_i.get(), fft_size, bins);
+        }
+        if (fft_size >= FFT_SIZE_FOURSTEP)
+            fft_fourstep_plan = std::make_unique<ymn::fft_fourstep_plan<T>>(e_2pi_i.get(), fft_size);
+        else
+            fft_plan = std::make_unique<ymn::fft_plan<T>>(e_2pi_i.get(), fft_size);
+    }
+
+    /* computed once, next to the twiddles, in the sample type's format */
+    const ymn::window_plan<T> window_plan(opts.window, fft_size, opts.window_beta);
+    ymn::frontend_dc_blocker dc_blocker; /* producer only, fed with every new chunk once */
+    std::unique_ptr<ymn::pfb_plan<T>> pfb_plan;
+    if (opts.pfb_taps > 0)
+        pfb_plan = std::make_unique<ymn::pfb_plan<T>>(fft_size, opts.pfb_taps, opts.pfb_oversample,
+            opts.window, opts.window_beta);
+    std::vector<IQ> pfb_scratch(pfb_plan ? pfb_plan->length() : 0);
+    std::size_t pfb_frames = 0;
+    const std::size_t fft_frame = pfb_plan ? pfb_plan->length() : fft_size;
+    const std::size_t fft_hop = pfb_plan ? pfb_plan->hop() : std::max(1, fft_size - fft_size * opts.overlap / 100);
+    ymn::integrator<T> integrator(opts.integrate > 0 ? fft_size : 0, opts.integrate);
+
+    if (opts.async_buffers > 0) {
+        /* chunks are what usb buffers deliver */
+        iqbuf_u8_size = opts.async_buffer_size;
+        ingest_pool = std::make_unique<ymn::ingest_pool>(
+            opts.async_buffers * ASYNC_POOL_BLOCKS_PER_BUFFER, opts.async_buffer_size);
+    }
+    else
+        iqbuf_u8_size = std::max<std::size_t>(IQBUF_SIZE_MIN, fft_size * 2);
+
+    /* zoom - whole chunks are down-converted, fft frames are taken from the decimated samples */
+    std::unique_ptr<ymn::zoom_ddc<T>> zoom_ddc;
+    std::unique_ptr<ymn::sample_history<IQ>> zoom_history;
+    std::vector<IQ> zoom_scratch;
+    if (opts.zoom_span > 0) {
+        const std::size_t decimation = ymn::zoom_decimation(opts.bandwidth, opts.zoom_span);
+        zoom_ddc = std::make_unique<ymn::zoom_ddc<T>>(
+            static_cast<double>(opts.zoom_center) - opts.frequency, opts.bandwidth, decimation);
+        zoom_history = std::make_unique<ymn::sample_history<IQ>>(fft_size, fft_hop, iqbuf_u8_size / 2 / decimation + 1);
+        zoom_scratch.resize(iqbuf_u8_size / 2);
+    }
+
+    /* frequencies the printed bins refer to */
+    const uint32_t spectrum_fc = zoom_ddc ? opts.zoom_center : opts.frequency;
+    const uint32_t spectrum_bw = zoom_ddc ? opts.bandwidth / zoom_ddc->decimation() : opts.bandwidth;
+
+    if (fft_bfp && std::is_floating_point<T>::value) {
+        fprintf(stderr, "Block floating point fft is for fixed point samples only, ignoring it\n");
+        fft_bfp = false;
+    }
+
+    if constexpr (!std::is_floating_point<T>::value)
+        if (ymn::fft_bfp_traits<T>::required && !fft_bfp) {
+            /* unscaled 16-bit q15 butterflies saturate (N times full scale does not fit), so -F is implied */
+            if (opts.fft_stockham || opts.fft_batch || opts.fft_verify)
+                fprintf(stderr, "q15 samples are always transformed in block floating point, which has no -s, -B nor -v "
+                    "variants, ignoring them\n");
+            fft_bfp = true;
+        }
+
+    if (opts.fft_batch && fft_plan && !opts.fft_stockham && !fft_bfp)
+        fft_batch_plan = std::make_unique<ymn::fft_batch_plan<T, FFT_BATCH_LANES>>(*fft_plan);
+
+    if (zoom_ddc) /* read buffer only, chunks go straight to the down-converter */
+        iqbuf_u8 = std::make_unique<ymn::sample_history<uint8_t>>(iqbuf_u8_size, iqbuf_u8_size, iqbuf_u8_size);
+    else
+        iqbuf_u8 = std::make_unique<ymn::sample_history<uint8_t>>(fft_frame * 2, fft_hop * 2, iqbuf_u8_size);
+
+    /* front-end has its own simd kernels (also for q15 samples), used whenever the cpu has them */
+    ymn::frontend_converter<T> frontend(opts.frontend);
+    if ((opts.frontend == ymn::frontend_engine::simd) && !frontend.has_simd()) {
+        fprintf(stderr, "There is no simd front-end for these samples on this cpu (avx2 and fma are needed)\n");
+        exit(EXIT_FAILURE);
+    }
+    double frontend_timings[3] = {};
+    if (zoom_ddc)
+        frontend.select(zoom_scratch.size(), nullptr, frontend_timings);
+    else
+    if (pfb_plan)
+        frontend.select(pfb_plan->length(), pfb_plan->coefficients(), frontend_timings);
+    else
+        frontend.select(fft_size, window_plan.coefficients(), frontend_timings);
+
+    if (std::is_same<T, float>::value && (fft_isa == ymn::fft_isa::sse41))
+        fft_isa = ymn::fft_isa::scalar; /* there are avx2 kernels only for float samples */
+    else
+    if (!std::is_same<T, ymn::fixq15>::value && !std::is_same<T, float>::value)
+        fft_isa = ymn::fft_isa::scalar; /* simd kernels are there for fixq15 and float samples only */
+
+    fft_isa = ymn::fft_isa_resolve(fft_isa);
+    if (fft_fourstep_plan)
+        fprintf(stderr, "Using scalar four-step fft kernels (%zu x %zu)\n",
+            fft_fourstep_plan->n1(), fft_fourstep_plan->n2());
+    else
+    if (fft_bfp)
+        fprintf(stderr, "Using scalar block floating point fft kernels\n");
+    else
+    if (opts.fft_stockham)
+        fprintf(stderr, "Using scalar stockham fft kernels\n");
+    else
+    if (fft_batch_plan)
+        fprintf(stderr, "Using %s batched fft kernels (%d frames at once)\n",
+            ymn::fft_isa_to_string(fft_isa), FFT_BATCH_LANES);
+    else
+        fprintf(stderr, "Using %s fft kernels%s\n",
+            ymn::fft_isa_to_string(fft_isa), opts.fft_verify ? " (verified against scalar ones)" : "");
+    if (pfb_plan)
+        fprintf(stderr, "Using %zu taps per branch %spolyphase filter bank (%s prototype window)\n",
+            pfb_plan->taps(), opts.pfb_oversample ? "2x oversampled " : "", ymn::window_to_string(opts.window));
+    else
+        fprintf(stderr, "Using %s window\n", ymn::window_to_string(window_plan.type()));
+    if ((opts.frontend == ymn::frontend_engine::automatic) && frontend.has_simd())
+        fprintf(stderr, "Using %s front-end (direct %.2f, table %.2f, simd %.2f ns per sample)\n",
+            ymn::frontend_engine_to_string(frontend.engine()),
+            frontend_timings[0], frontend_timings[1], frontend_timings[2]);
+    else
+    if (opts.frontend == ymn::frontend_engine::automatic)
+        fprintf(stderr, "Using %s front-end (direct %.2f, table %.2f ns per sample, no simd one on this cpu)\n",
+            ymn::frontend_engine_to_string(frontend.engine()), frontend_timings[0], frontend_timings[1]);
+    else
+        fprintf(stderr, "Using %s front-end\n", ymn::frontend_engine_to_string(frontend.engine()));
+    if (ingest_pool)
+        fprintf(stderr, "Using async ingest (%d usb buffers of %u bytes, %d pool blocks)\n",
+            opts.async_buffers, opts.async_buffer_size, opts.async_buffers * ASYNC_POOL_BLOCKS_PER_BUFFER);
+    if (zoom_ddc) {
+        fprintf(stderr, "Zooming into %u Hz around %u Hz (decimated by %zu, %u Hz sample rate)\n",
+            opts.zoom_span, opts.zoom_center, zoom_ddc->decimation(), spectrum_bw);
+        /* a tone at the zoom centre shall come out as dc only, tones folding onto span edges shall be gone */
+        const double offset = static_cast<double>(opts.zoom_center) - opts.frequency;
+        const double images = std::max(ymn::zoom_images_db<T>(offset, opts.bandwidth, zoom_ddc->decimation()),
+            ymn::zoom_edge_images_db<T>(offset, opts.zoom_span, opts.bandwidth, zoom_ddc->decimation()));
+        if (images > ZOOM_IMAGES_MAX_DB)
+            fprintf(stderr, "Zoom down-conversion leaves images/spurs at %.1f dBc (more than %.1f dBc)\n",
+                images, ZOOM_IMAGES_MAX_DB);
+        else
+        if (opts.fft_verify)
+            fprintf(stderr, "Zoom down-conversion images/spurs are at %.1f dBc\n", images);
+    }
+
+    std::vector<IQ> fft_scratch((opts.fft_stockham || fft_fourstep_plan) ? fft_size : 0);
+    std::vector<float> fft_db((PRINT_FFT_SPECTRA && (opts.integrate == 0)) ? fft_size : 0); /* dense dB spectrum of the last frame */
+
+    std::unique_ptr<ymn::iq_throttle> input_throttle;
+    uint64_t input_samples = 0;
+
+    uint64_t frame_sequence = 0;
+
+    auto discontinuity = [&](){
+        iqbuf_u8->clear(); /* no frame shall span the gap */
+        ++frame_sequence; /* stages see it as a dropped frame */
+        if (zoom_ddc) {
+            zoom_ddc->reset();
+            zoom_history->clear();
+        }
+    };
+
+    auto emit_zoom_frames = [&](const uint8_t* src, std::size_t n, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
+
+        /* whole chunk (short last one of a capture as well) is converted (no window), */
+        /* down-converted and appended to decimated samples */
+        frontend.convert(zoom_scratch.data(), src, nullptr, n, dc_blocker.correction());
+        zoom_history->append(zoom_ddc->process(zoom_scratch.data(), n, zoom_history->tail()));
+
+        while (const IQ* frame = zoom_history->next_frame()) {
+            iq_buffer_uptr<IQ> iqbuf_uptr = pipeline->get_buffer<buffer<IQ>>(fft_size);
+            iqbuf_uptr->exponent = 0;
+            iqbuf_uptr->sequence = frame_sequence++;
+            ymn::zoom_window(iqbuf_uptr->vector.data(), frame, window_plan.coefficients(), fft_size);
+            put_iq_buffer_uptr(orb, std::move(iqbuf_uptr));
+        }
+    };
+
+    auto emit_frames = [&](ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
+
+        /* consecutive frames are views of the same history (overlapping ones share samples) */
+        while (const uint8_t* src = iqbuf_u8->next_frame()) {
+            /* recycled buffer, every sample gets overwritten */
+            iq_buffer_uptr<IQ> iqbuf_uptr = pipeline->get_buffer<buffer<IQ>>(fft_size);
+            IQ* iqbuf = iqbuf_uptr->vector.data();
+            iqbuf_uptr->exponent = 0;
+            iqbuf_uptr->sequence = frame_sequence++;
+
+            /* scale [0, 255] -> [-127, 128] -> [-32512, 32768], remove dc and apply window */
+            /* (all in one pass, straight into the fft input buffer) */
+            if (pfb_plan)
+                ymn::pfb_u8(iqbuf, pfb_scratch.data(), src, *pfb_plan,
+                    (pfb_frames++ * fft_hop) & (fft_size - 1), dc_blocker.correction(), frontend);
+            else
+                frontend.convert(iqbuf, src, window_plan.coefficients(), fft_size, dc_blocker.correction());
+
+            long write_status = orb->write(std::move(iqbuf_uptr));
+            if (write_status != 1) {
+               fprintf(stderr, "%s: orb->write() failed\n", __PRETTY_FUNCTION__);
+               fprintf(stderr, "%s\n", orb->to_string().c_str());
+            }
+        }
+    };
 
     auto producer = [&](ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
 
@@ -269,146 +1000,329 @@ int main(int argc, char *argv[])
         int n_read;
         static std::size_t counter = 0;
 
-        status = rtlsdr_read_sync(rtlsdr_device, iqbuf_u8, sizeof(iqbuf_u8), &n_read);
-        if (status) {
-            fprintf(stderr, "rtlsdr_read_sync(%zu) failed\n", sizeof(iqbuf_u8));
-            return false;
-        }
+        if (ingest_pool) {
+            /* filled by async_callback(), frames are converted straight from the block, */
+            /* which goes back to the pool once only its unconsumed tail is left in the history */
+            ymn::ingest_block* block = ingest_pool->next();
+            if (block == nullptr)
+                return false;
 
-        if (n_read != sizeof(iqbuf_u8)) {
-            fprintf(stderr, "rtlsdr_read_sync(%zu) dropped samples - received %d\n",
-                sizeof(iqbuf_u8), n_read);
-            return true;
-        }
+            if (block->gap) {
+                fprintf(stderr, "async ingest dropped samples - %zu bytes so far\n", ingest_pool->dropped());
+                discontinuity();
+            }
 
-        if (counter++ < IDLE_LOOPS_NUM)
-            return true;
+            if (counter++ >= IDLE_LOOPS_NUM) {
+                dc_blocker.track(block->data, block->length / 2);
+                if (zoom_ddc)
+                    emit_zoom_frames(block->data, block->length / 2, orb);
+                else {
+                    iqbuf_u8->attach(block->data, block->length);
+                    emit_frames(orb);
+                    iqbuf_u8->detach();
+                }
+            }
+
+            ingest_pool->release(block);
 
-        for (std::size_t offset = 0; offset < sizeof(iqbuf_u8); offset += (fft_size * 2)) {
-            iq_buffer_uptr iqbuf_uptr = std::make_unique<buffer<iq_t>>(fft_size);
-            iq_t* iqbuf = iqbuf_uptr->vector.data();
-            const uint8_t* src = &iqbuf_u8[offset];
-
-            /* scale [0, 255] -> [-127, 128] */
-            /* scale [-127, 128] -> [-32512, 32768] */
-            for (int i = 0; i < fft_size; ++i) {
-                iqbuf[i].real((src[2 * i + 0] - 127) * 256);
-                iqbuf[i].imag((src[2 * i + 1] - 127) * 256);
-				fprintf(fp, "%d   %d\n", src[2 * i + 0] - 127, src[2 * i + 1] - 127);
+            return true;
+        }
+        else
+        if (iq_source) {
+            /* offline source, paced to the sample rate unless unthrottled */
+            n_read = static_cast<int>(iq_source->read(iqbuf_u8->tail(), iqbuf_u8_size));
+            if (n_read == 0)
+                return false; /* end of input, stages drain what is still queued */
+            input_samples += n_read / 2;
+            if (input_throttle)
+                input_throttle->wait(n_read / 2);
+        }
+        else {
+            status = rtlsdr_read_sync(rtlsdr_device, iqbuf_u8->tail(), iqbuf_u8_size, &n_read);
+            if (status) {
+                fprintf(stderr, "rtlsdr_read_sync(%zu) failed\n", iqbuf_u8_size);
+                return false;
             }
 
-            long write_status = orb->write(std::move(iqbuf_uptr));
-            if (write_status != 1) {
-               fprintf(stderr, "%s: orb->write() failed\n", __PRETTY_FUNCTION__);
-               fprintf(stderr, "%s\n", orb->to_string().c_str());
+            if (n_read != static_cast<int>(iqbuf_u8_size)) {
+                fprintf(stderr, "rtlsdr_read_sync(%zu) dropped samples - received %d\n",
+                    iqbuf_u8_size, n_read);
+                discontinuity();
+                return true;
             }
         }
 
+        if (!iq_source && (counter++ < IDLE_LOOPS_NUM))
+            return true;
+
+        dc_blocker.track(iqbuf_u8->tail(), n_read / 2); /* chunk has just been read to tail() */
+        if (zoom_ddc)
+            emit_zoom_frames(iqbuf_u8->tail(), n_read / 2, orb); /* chunks are not kept, tail() stays put */
+        else {
+            iqbuf_u8->append(n_read);
+            emit_frames(orb);
+        }
+
         return true;
     };
 
     auto fft_stage = [&](ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
 
         assert(irb != nullptr);
-        assert(orb == nullptr);
 
-        iq_buffer_uptr iqbuf_uptr = get_iq_buffer_uptr(irb);
+        iq_buffer_uptr<IQ> iqbuf_uptr = get_iq_buffer_uptr<IQ>(irb);
         if (!iqbuf_uptr)
             return false;
 
-        remove_dc(iqbuf_uptr->vector.data(), fft_size); // Is it necessary?
-        fft(iqbuf_uptr->vector.data(), e_2pi_i.get(), fft_size);
+        if (fft_fourstep_plan)
+            ymn::fft_fourstep(*fft_fourstep_plan, iqbuf_uptr->vector.data(), fft_scratch.data());
+        else
+        if (fft_bfp) {
+            if constexpr (!std::is_floating_point<T>::value)
+                iqbuf_uptr->exponent = ymn::fft_bfp(*fft_plan, iqbuf_uptr->vector.data());
+        }
+        else
+        if (opts.fft_stockham)
+            ymn::fft_stockham(*fft_plan, iqbuf_uptr->vector.data(), fft_scratch.data());
+        else
+        if (opts.fft_verify) {
+            std::vector<IQ> reference(iqbuf_uptr->vector.begin(), iqbuf_uptr->vector.end());
+            ymn::fft(*fft_plan, reference.data());
+            ymn::fft(*fft_plan, iqbuf_uptr->vector.data(), fft_isa);
+            if (!ymn::fft_verify(iqbuf_uptr->vector.data(), reference.data(), fft_size))
+                fprintf(stderr, "%s fft output differs from scalar one\n", ymn::fft_isa_to_string(fft_isa));
+        }
+        else
+            ymn::fft(*fft_plan, iqbuf_uptr->vector.data(), fft_isa);
 
-        //fprintf(fp, "%s\n", irb->to_string().c_str());
+        //fprintf(opts.fp, "%s\n", irb->to_string().c_str());
 
-        print_fft(fp, frequency, bandwidth, iqbuf_uptr->vector.data(), fft_size);
+        if (orb)
+            put_iq_buffer_uptr(orb, std::move(iqbuf_uptr));
+        else
+        if (PRINT_FFT_SPECTRA) {
+            ymn::power_db(fft_db.data(), iqbuf_uptr->vector.data(), fft_size, iqbuf_uptr->exponent, fft_isa);
+            print_fft(opts.fp, spectrum_fc, spectrum_bw, fft_db.data(), fft_size);
+        }
 
         return true;
     };
 
-    ymn::pipeline::stage_function functions[] = {producer, fft_stage};
-    pipeline = std::make_unique<ymn::pipeline>(functions, 42);
+    auto fft_batch_stage = [&](ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
 
-    pipeline->start();
-    pipeline->join();
+        assert(irb != nullptr);
 
-    rtlsdr_close(rtlsdr_device);
+        ymn::pipeline::buffer_uptr buf_uptrs[FFT_BATCH_LANES];
+        iq_buffer_uptr<IQ> iqbuf_uptrs[FFT_BATCH_LANES];
+        IQ* frames[FFT_BATCH_LANES];
 
-    if (fp != stdout)
-        fclose(fp);
+        /* takes whatever is already there (up to FFT_BATCH_LANES frames) */
+        long read_status = irb->read(std::move(buf_uptrs));
+        if (read_status < 1)
+            return false;
 
-    return 0;
-}
+        /* end of stream marker (empty buffer) ends the batch and the stage */
+        std::size_t count = 0;
+        while ((count < static_cast<std::size_t>(read_status)) && buf_uptrs[count]) {
+            iqbuf_uptrs[count] = to_iq_buffer_uptr<IQ>(std::move(buf_uptrs[count]));
+            frames[count] = iqbuf_uptrs[count]->vector.data();
+            ++count;
+        }
+        const bool end_of_stream = count < static_cast<std::size_t>(read_status);
+
+        if (count > 0)
+            ymn::fft_batch(*fft_batch_plan, frames, count, fft_isa);
+
+        for (std::size_t k = 0; k < count; ++k)
+            if (orb)
+                put_iq_buffer_uptr(orb, std::move(iqbuf_uptrs[k]));
+            else
+            if (PRINT_FFT_SPECTRA) {
+                ymn::power_db(fft_db.data(), frames[k], fft_size, iqbuf_uptrs[k]->exponent, fft_isa);
+                print_fft(opts.fp, spectrum_fc, spectrum_bw, fft_db.data(), fft_size);
+            }
 
-/*===========================================================================*\
- * local function definitions
-\*===========================================================================*/
-static void print_usage(const char* progname)
-{
-    fprintf(stdout, "usage: %s -f <frequency> [-b <bandwidth>] [-n <fft_size>] [<filename>]\n", progname);
-    fprintf(stdout, " options:\n");
-    fprintf(stdout, "  -f <frequency>  --frequency=<frequency> : center frequency to tune to\n");
-    fprintf(stdout, "  -b <bandwidth>  --bandwidth=<bandwidth> : bandwidth to be scanned (default: 2 MHz)\n");
-    fprintf(stdout, "  -n <fft size>   --fft-size=<fft size>   : fft size (default: 2048)\n");
-    fprintf(stdout, "  <filename>                              : print output values to this file (default: stdout)\n");
-}
+        return !end_of_stream;
+    };
 
-static void signal_handler(int signum)
-{
-    fprintf(stderr, "caught signal %d, terminating ...\n", signum);
-    if (pipeline != nullptr)
-        pipeline->stop();
-    fprintf(stderr, "done\n");
-}
+    auto integrate_stage = [&](ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
 
-static void install_signal_handler(void)
-{
-    struct sigaction sigact;
+        assert(irb != nullptr);
+        assert(orb == nullptr);
 
-    sigact.sa_handler = signal_handler;
-    sigemptyset(&sigact.sa_mask);
-    sigact.sa_flags = 0;
+        iq_buffer_uptr<IQ> iqbuf_uptr = get_iq_buffer_uptr<IQ>(irb);
+        if (!iqbuf_uptr)
+            return false;
 
-    sigaction(SIGINT, &sigact, NULL);
-    sigaction(SIGTERM, &sigact, NULL);
-    sigaction(SIGQUIT, &sigact, NULL);
-    sigaction(SIGPIPE, &sigact, NULL);
-}
+        ymn::integrate(integrator, iqbuf_uptr->vector.data(), iqbuf_uptr->exponent, fft_isa);
+        if (integrator.ready()) {
+            print_power(opts.fp, spectrum_fc, spectrum_bw, integrator.power(), fft_size, integrator.count());
+            integrator.reset();
+        }
 
-static void remove_dc(iq_t* iqbuf, const std::size_t N)
-{
-    iq_t sum(0, 0);
+        return true;
+    };
+
+    auto sdft_stage = [&](ymn::iringbuffer<ymn::pipeline::buffer_uptr>* irb, ymn::oringbuffer<ymn::pipeline::buffer_uptr>* orb){
+
+        assert(irb != nullptr);
+        assert(orb != nullptr);
+
+        iq_buffer_uptr<IQ> iqbuf_uptr = get_iq_buffer_uptr<IQ>(irb);
+        if (!iqbuf_uptr)
+            return false;
 
-    for (std::size_t n = 0; n < N; ++n)
-        sum += iqbuf[n];
+        /* frames dropped by a full queue (or lost before) would leave stale samples in the history */
+        if (iqbuf_uptr->sequence != sdft_sequence)
+            sliding_dft->restart();
+        sdft_sequence = iqbuf_uptr->sequence + 1;
+
+        /* sees the samples before the (in-place) fft, one by one - but only once the whole read */
+        /* holding the frame is in, so updates come in bursts of a read (latency of up to a read) */
+        const IQ* iqbuf = iqbuf_uptr->vector.data();
+        const double threshold = pow(10.0, opts.sdft_threshold / 10.0);
+        for (int n = 0; n < fft_size; ++n, ++sdft_samples) {
+            sliding_dft->update(iqbuf[n]);
+            if (!opts.sdft_alarm || !sliding_dft->complete())
+                continue; /* partly filled window would raise false alarms */
+            for (std::size_t b = 0; b < sliding_dft->bins_count(); ++b) {
+                const double power = sliding_dft->power(b);
+                if ((power >= threshold) == sdft_alarms[b])
+                    continue;
+                sdft_alarms[b] = !sdft_alarms[b];
+                fprintf(opts.fp, "%12lu\t\t%8zu\t\t%8u Hz\t\t%8.2f dB\t\t%s\n",
+                    sdft_samples,
+                    opts.sdft_bins[b],
+                    spectrum_fc - (spectrum_bw / 2) + static_cast<uint32_t>(opts.sdft_bins[b] * (spectrum_bw / fft_size)),
+                    ymn::power_db_from_power(static_cast<float>(power), 0),
+                    sdft_alarms[b] ? "on" : "off");
+            }
+        }
 
-    iq_t average = sum / ymn::fixq15(N * Q15);
+        if (!opts.sdft_alarm)
+            print_sdft(opts.fp, spectrum_fc, spectrum_bw, *sliding_dft);
 
-    //fprintf(stderr, "dc component: %s\n", average.to_string().c_str());
+        put_iq_buffer_uptr(orb, std::move(iqbuf_uptr));
 
-    if (average == iq_t(0, 0))
-        return;
+        return true;
+    };
 
-    for (std::size_t n = 0; n < N; ++n)
-        iqbuf[n] -= average;
+    std::vector<ymn::pipeline::stage_function> functions{producer};
+    if (sliding_dft)
+        functions.push_back(sdft_stage);
+    if (fft_batch_plan)
+        functions.push_back(fft_batch_stage);
+    else
+        functions.push_back(fft_stage);
+    if (opts.integrate > 0)
+        functions.push_back(integrate_stage);
+
+    /* unthrottled offline source shall not outrun the pipeline (no frame is dropped then) */
+    if (iq_source && opts.input_unthrottled)
+        pipeline = std::make_unique<ymn::pipeline>(functions, 42, RINGBUFFER_RD_BLOCKING_WR_BLOCKING);
+    else
+        pipeline = std::make_unique<ymn::pipeline>(functions, 42);
+    /* frames in flight grow the pool further if needed, until it reaches steady state */
+    pipeline->reserve_buffers<buffer<IQ>>(functions.size() + FFT_BATCH_LANES, fft_size);
+
+    std::thread ingest_thread;
+    if (ingest_pool)
+        ingest_thread = std::thread([&](){
+            const int status = rtlsdr_read_async(rtlsdr_device, async_callback, ingest_pool.get(),
+                opts.async_buffers, opts.async_buffer_size);
+            if (status)
+                fprintf(stderr, "rtlsdr_read_async() failed (%d)\n", status);
+            ingest_pool->cancel(); /* nothing more is coming */
+        });
+
+    if (iq_source && !opts.input_unthrottled)
+        input_throttle = std::make_unique<ymn::iq_throttle>(opts.bandwidth);
+
+    const auto start = std::chrono::steady_clock::now();
+    pipeline->start();
+    pipeline->join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (ingest_thread.joinable()) {
+        rtlsdr_cancel_async(rtlsdr_device);
+        ingest_thread.join();
+    }
+
+    fprintf(stderr, "%zu frame buffers have been allocated\n", pipeline->allocated_buffers());
+    if (iq_source)
+        fprintf(stderr, "%llu samples processed in %.3f s (%.2f Msps, %.2f x real time)\n",
+            static_cast<unsigned long long>(input_samples), elapsed.count(),
+            input_samples / elapsed.count() / 1e6, input_samples / elapsed.count() / opts.bandwidth);
 }
 
-static void print_fft(FILE *fp, uint32_t fc, uint32_t bw, iq_t* iqbuf, const std::size_t N)
+static void print_fft(FILE *fp, uint32_t fc, uint32_t bw, const float* db, const std::size_t N)
 {
-	#if 0
+	#if PRINT_FFT_SPECTRA
+    /* power in dB, 0 dB being full scale (|X|^2 of 1.0), see power_db() */
     uint32_t f = fc - (bw / 2);
     uint32_t f_step = bw / N;
 
     for (std::size_t n = 0; n < N; ++n, f += f_step)
-        fprintf(fp, "%8zu\t\t%8u Hz\t\t%8ld\t\t%8ld\t\t%8ld\n",
+        fprintf(fp, "%8zu\t\t%8u Hz\t\t%8.2f dB\n",
             n,
             f,
-            iqbuf[n].real().value() / Q15,
-            iqbuf[n].imag().value() / Q15,
-            iqbuf[n].norm().value() / Q15);
+            db[n]);
 			#endif
 }
 
+template<typename A>
+static void print_power(FILE *fp, uint32_t fc, uint32_t bw, const A* power, const std::size_t N, std::size_t frames)
+{
+    /* averaged power in dB, 0 dB being full scale (|X|^2 of 1.0), see power_db_from_power() */
+    const double scale = 1.0 / frames;
+    uint32_t f = fc - (bw / 2);
+    uint32_t f_step = bw / N;
+
+    for (std::size_t n = 0; n < N; ++n, f += f_step)
+        fprintf(fp, "%8zu\t\t%8u Hz\t\t%8.2f dB\n",
+            n,
+            f,
+            ymn::power_db_from_power(static_cast<float>(static_cast<double>(power[n]) * scale), 0));
+
+    fprintf(fp, "\n");
+}
+
+template<typename T>
+static void print_sdft(FILE *fp, uint32_t fc, uint32_t bw, const ymn::sliding_dft<T>& sdft)
+{
+    /* bins are printed dc-centred, as fft ones */
+    const std::size_t N = sdft.size();
+
+    for (std::size_t b = 0; b < sdft.bins_count(); ++b) {
+        const std::size_t n = (sdft.bins()[b] + N / 2) % N;
+        fprintf(fp, "%8zu\t\t%8u Hz\t\t%8.2f dB\n",
+            n,
+            fc - (bw / 2) + static_cast<uint32_t>(n * (bw / N)),
+            ymn::power_db_from_power(static_cast<float>(sdft.power(b)), 0));
+    }
+
+    fprintf(fp, "\n");
+}
+
+static bool parse_bins(const char* str, std::vector<std::size_t>& bins)
+{
+    /* e.g. "1000,1024,1100" */
+    std::string list(str);
+    std::size_t begin = 0;
+
+    for (;;) {
+        const std::size_t end = list.find(',', begin);
+        const std::string token = list.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        std::size_t bin;
+        if (ymn::strtointeger(token.c_str(), bin) != ymn::strtointeger_conversion_status_e::success)
+            return false;
+        bins.push_back(bin);
+        if (end == std::string::npos)
+            return true;
+        begin = end + 1;
+    }
+}
+
 static int verbose_device_search(const char *s)
 {
     int i, device_count, device, offset;
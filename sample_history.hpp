@@ -0,0 +1,200 @@
+/**
+ * @file sample_history.hpp
+ *
+ * Contiguous history of incoming samples, from which (possibly overlapping)
+ * frames are handed out as views - consecutive frames share their samples
+ * instead of having them duplicated. New chunks are appended right behind
+ * the samples not consumed yet, so frames also span chunk boundaries.
+ * Only the unconsumed tail (shorter than a frame) is moved to the front,
+ * once per chunk.
+ * Chunks which already are in memory (e.g. blocks of an ingest pool) can
+ * be attached instead of appended - frames lying within such a chunk are
+ * views of the chunk itself, only the samples that frames starting in the
+ * history need and the unconsumed tail of the chunk get copied.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _SAMPLE_HISTORY_HPP_
+#define _SAMPLE_HISTORY_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+class sample_history
+{
+public:
+    /* frame and hop (distance between starts of consecutive frames) are given in elements, */
+    /* up to chunk elements are appended at once */
+    explicit sample_history(std::size_t frame, std::size_t hop, std::size_t chunk) :
+        m_frame{frame},
+        m_hop{std::max<std::size_t>(1, std::min(hop, frame))},
+        m_chunk{chunk},
+        m_buffer(frame + chunk),
+        m_begin{0},
+        m_end{0},
+        m_attached{nullptr},
+        m_attached_size{0},
+        m_held{0}
+    {
+    }
+
+    std::size_t frame() const
+    {
+        return m_frame;
+    }
+
+    std::size_t hop() const
+    {
+        return m_hop;
+    }
+
+    std::size_t chunk() const
+    {
+        return m_chunk;
+    }
+
+    T* tail() /* room for the next chunk (of chunk() elements) */
+    {
+        if (m_begin > 0) {
+            std::copy(m_buffer.begin() + m_begin, m_buffer.begin() + m_end, m_buffer.begin());
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+
+        return m_buffer.data() + m_end;
+    }
+
+    void append(std::size_t n) /* n elements have been written at tail() */
+    {
+        m_end += std::min(n, m_chunk);
+    }
+
+    void attach(const T* chunk, std::size_t n) /* up to chunk() elements, valid until detach() */
+    {
+        /* frames starting in the history are completed with the beginning of the chunk */
+        T* t = tail();
+        const std::size_t k = (m_end > 0) ? std::min(n, ((m_end - 1) / m_hop) * m_hop + m_frame - m_end) : 0;
+
+        std::copy(chunk, chunk + k, t);
+        m_held = m_end;
+        m_end += k;
+        m_attached = chunk;
+        m_attached_size = std::min(n, m_chunk);
+    }
+
+    void detach() /* once all frames are taken, keeps the rest of the chunk (shorter than a frame) */
+    {
+        if (m_attached == nullptr)
+            return;
+
+        if (m_begin >= m_held) {
+            const std::size_t offset = std::min(m_begin - m_held, m_attached_size);
+            std::copy(m_attached + offset, m_attached + m_attached_size, m_buffer.begin());
+            m_end = m_attached_size - offset;
+            m_begin = 0;
+        }
+        /* otherwise the whole rest of the chunk has been copied by attach() already */
+
+        m_attached = nullptr;
+        m_attached_size = 0;
+        m_held = 0;
+    }
+
+    const T* next_frame() /* nullptr when there is not enough samples for a full frame */
+    {
+        if (m_attached) {
+            if (m_held + m_attached_size - m_begin < m_frame)
+                return nullptr;
+
+            const T* frame = (m_begin < m_held) ? m_buffer.data() + m_begin : m_attached + (m_begin - m_held);
+            m_begin += m_hop;
+
+            return frame;
+        }
+
+        if (m_end - m_begin < m_frame)
+            return nullptr;
+
+        const T* frame = m_buffer.data() + m_begin;
+        m_begin += m_hop;
+
+        return frame;
+    }
+
+    void clear() /* on discontinuity, frames shall not span it */
+    {
+        m_begin = 0;
+        m_end = 0;
+        m_attached = nullptr;
+        m_attached_size = 0;
+        m_held = 0;
+    }
+
+private:
+    std::size_t m_frame;
+    std::size_t m_hop;
+    std::size_t m_chunk;
+    std::vector<T> m_buffer;
+    std::size_t m_begin; /* first not consumed element */
+    std::size_t m_end;
+    const T* m_attached; /* chunk read in place, it follows m_held elements of the history */
+    std::size_t m_attached_size;
+    std::size_t m_held;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _SAMPLE_HISTORY_HPP_ */
@@ -0,0 +1,215 @@
+/**
+ * @file sliding_dft.hpp
+ *
+ * Sliding dft - selected bins of the N point dft of the last N samples
+ * are updated with every incoming sample in O(bins) work,
+ * X[k] <- (X[k] - x[n - N] + x[n]) * e^(-2*pi*i*k/N) (for fft() sign convention).
+ * Rounding errors of the recursion are flushed once per N samples - the
+ * direct dft of each N sample window is accumulated alongside, one term
+ * per sample, and replaces the recursive bins when the window is complete
+ * (O(bins) per sample as well, with no O(N * bins) bursts).
+ * After a gap in the samples the history is stale, restart() clears it.
+ * Fixed point samples are processed in fixq15, so narrow q15 ones do not
+ * saturate on the dft gain.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _SLIDING_DFT_HPP_
+#define _SLIDING_DFT_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "fixq15.hpp"
+#include "complex.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+struct sliding_dft_traits
+{
+    /* type the recursion runs in */
+    using value_type = std::conditional_t<std::is_floating_point<T>::value, T, fixq15>;
+
+    static value_type convert(const T& v)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return v;
+        else
+            return fixq15(static_cast<int64_t>(v.value()));
+    }
+
+    static double to_double(const value_type& v) /* 1.0 is 1.0 */
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return v;
+        else
+            return static_cast<double>(v.value()) / Q15;
+    }
+};
+
+template<typename T>
+class sliding_dft
+{
+public:
+    using value_type = typename sliding_dft_traits<T>::value_type;
+
+    /* e is the N element table of e^(2*pi*i*k/N) as for fft_plan (N being power of 2), */
+    /* bins are natural (not dc-centred) dft indices */
+    explicit sliding_dft(const complex<T>* e, std::size_t N, const std::vector<std::size_t>& bins) :
+        m_size{N},
+        m_e(N),
+        m_bins(bins),
+        m_rotations(bins.size()),
+        m_spectrum(bins.size()),
+        m_direct(bins.size()),
+        m_history(N),
+        m_position{0},
+        m_count{0},
+        m_complete{false}
+    {
+        for (std::size_t n = 0; n < N; ++n)
+            m_e[n] = convert(e[n]);
+
+        for (std::size_t b = 0; b < m_bins.size(); ++b) {
+            m_bins[b] %= N;
+            m_rotations[b] = m_e[(N - m_bins[b]) % N];
+        }
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    std::size_t bins_count() const
+    {
+        return m_bins.size();
+    }
+
+    const std::size_t* bins() const
+    {
+        return m_bins.data();
+    }
+
+    const complex<value_type>* spectrum() const /* X[bins[b]] of the last N samples */
+    {
+        return m_spectrum.data();
+    }
+
+    bool complete() const /* N samples have been seen since the start (or restart) */
+    {
+        return m_complete;
+    }
+
+    double power(std::size_t b) const /* |X[bins[b]]|^2, 1.0 being |1.0|^2 */
+    {
+        const double re = sliding_dft_traits<T>::to_double(m_spectrum[b].real());
+        const double im = sliding_dft_traits<T>::to_double(m_spectrum[b].imag());
+
+        return re * re + im * im;
+    }
+
+    void update(const complex<T>& sample)
+    {
+        const complex<value_type> x = convert(sample);
+        const complex<value_type> delta = x - m_history[m_position];
+
+        m_history[m_position] = x;
+        m_position = (m_position + 1) & (m_size - 1);
+
+        /* X[k] = sum x[n - N + 1 + j] * e^(2*pi*i*k*j/N), j being m_count for the direct one */
+        for (std::size_t b = 0; b < m_spectrum.size(); ++b) {
+            m_spectrum[b] = (m_spectrum[b] + delta) * m_rotations[b];
+            m_direct[b] += x * m_e[(m_bins[b] * m_count) & (m_size - 1)];
+        }
+
+        if (++m_count == m_size) {
+            m_count = 0;
+            m_complete = true;
+            m_spectrum.swap(m_direct);
+            std::fill(m_direct.begin(), m_direct.end(), complex<value_type>(0, 0));
+        }
+    }
+
+    void restart() /* next samples do not follow the previous ones */
+    {
+        std::fill(m_spectrum.begin(), m_spectrum.end(), complex<value_type>(0, 0));
+        std::fill(m_direct.begin(), m_direct.end(), complex<value_type>(0, 0));
+        std::fill(m_history.begin(), m_history.end(), complex<value_type>(0, 0));
+        m_position = 0;
+        m_count = 0;
+        m_complete = false;
+    }
+
+private:
+    static complex<value_type> convert(const complex<T>& c)
+    {
+        return complex<value_type>(sliding_dft_traits<T>::convert(c.real()), sliding_dft_traits<T>::convert(c.imag()));
+    }
+
+    std::size_t m_size;
+    std::vector<complex<value_type>> m_e;
+    std::vector<std::size_t> m_bins;
+    std::vector<complex<value_type>> m_rotations;
+    std::vector<complex<value_type>> m_spectrum;
+    std::vector<complex<value_type>> m_direct; /* direct dft of the window being filled */
+    std::vector<complex<value_type>> m_history; /* circular, last N samples */
+    std::size_t m_position; /* oldest sample (to be replaced next) */
+    std::size_t m_count; /* samples of the window being filled */
+    bool m_complete;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _SLIDING_DFT_HPP_ */
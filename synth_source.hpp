@@ -0,0 +1,425 @@
+/**
+ * @file synth_source.hpp
+ *
+ * Deterministic synthetic signal source - a sum of tones, linear chirps,
+ * gated tone bursts and gaussian noise, quantised to u8 (I, Q) samples as
+ * an rtlsdr device would deliver them. Same configuration and seed give
+ * the same samples on every machine, so pipeline throughput can be
+ * measured and compared without any hardware (paced by iq_throttle, or
+ * not paced at all).
+ * Oscillators are complex phasors rotated once per sample (and brought
+ * back to the unit circle once per block), noise is the sum of four
+ * uniform variables (Irwin-Hall, good enough a gaussian for spectra)
+ * drawn from a seeded xorshift generator.
+ *
+ * Configuration (text after "synth:", comma separated key=value pairs):
+ *   tones=<offset>[@<dBFS>][/...]                 tones, offsets in Hz from the centre
+ *   chirps=<from>:<to>:<period>[@<dBFS>][/...]    sweeps from -> to Hz every period s
+ *   bursts=<offset>:<on>:<period>[@<dBFS>][/...]  tones on for 'on' s every period s
+ *   noise=<dBFS>                                  gaussian noise (total power)
+ *   seed=<n>                                      noise generator seed
+ *   samples=<n>                                   input length (default: endless)
+ * Signals are at SYNTH_LEVEL_DEFAULT dBFS unless told otherwise, 0 dBFS
+ * being a full scale sinusoid.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _SYNTH_SOURCE_HPP_
+#define _SYNTH_SOURCE_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "iq_source.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define SYNTH_PREFIX "synth"
+#define SYNTH_LEVEL_DEFAULT -20.0 /* dBFS */
+#define SYNTH_SEED_DEFAULT 1
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+struct synth_signal
+{
+    double from; /* Hz, offset from the centre frequency */
+    double to;   /* Hz, chirps only */
+    double on;   /* s, bursts only */
+    double period; /* s, chirps and bursts only */
+    double level; /* dBFS */
+};
+
+struct synth_config
+{
+    std::vector<synth_signal> tones;
+    std::vector<synth_signal> chirps;
+    std::vector<synth_signal> bursts;
+    double noise = -HUGE_VAL; /* dBFS, -inf - no noise */
+    uint64_t seed = SYNTH_SEED_DEFAULT;
+    uint64_t samples = 0; /* 0 - endless */
+};
+
+class synth_oscillator
+{
+public:
+    explicit synth_oscillator(double frequency, double sample_rate, double level) :
+        m_re{1.0},
+        m_im{0.0},
+        m_amplitude{pow(10.0, level / 20.0)}
+    {
+        frequency_set(frequency, sample_rate);
+    }
+
+    void frequency_set(double frequency, double sample_rate)
+    {
+        m_step_re = cos(2.0 * M_PI * frequency / sample_rate);
+        m_step_im = sin(2.0 * M_PI * frequency / sample_rate);
+    }
+
+    void add(float* re, float* im) /* adds current sample and advances by one */
+    {
+        *re += static_cast<float>(m_amplitude * m_re);
+        *im += static_cast<float>(m_amplitude * m_im);
+        rotate(m_re, m_im, m_step_re, m_step_im);
+    }
+
+    void skip() /* advances without adding (gated off bursts stay phase continuous) */
+    {
+        rotate(m_re, m_im, m_step_re, m_step_im);
+    }
+
+    void chirp(double step_re, double step_im) /* rotates frequency step itself */
+    {
+        rotate(m_step_re, m_step_im, step_re, step_im);
+    }
+
+    void normalise() /* once per block, rounding errors would change amplitude otherwise */
+    {
+        double m = 1.0 / sqrt(m_re * m_re + m_im * m_im);
+        m_re *= m;
+        m_im *= m;
+        m = 1.0 / sqrt(m_step_re * m_step_re + m_step_im * m_step_im);
+        m_step_re *= m;
+        m_step_im *= m;
+    }
+
+private:
+    static void rotate(double& re, double& im, double by_re, double by_im)
+    {
+        const double r = re * by_re - im * by_im;
+        im = re * by_im + im * by_re;
+        re = r;
+    }
+
+    double m_re;
+    double m_im;
+    double m_step_re;
+    double m_step_im;
+    double m_amplitude;
+};
+
+class synth_source : public iq_source
+{
+public:
+    explicit synth_source(const synth_config& config, double sample_rate) :
+        m_config{config},
+        m_sample_rate{sample_rate},
+        m_tones(),
+        m_chirps(),
+        m_bursts(),
+        m_noise{static_cast<float>(sqrt(pow(10.0, config.noise / 10.0) / 2.0) * sqrt(3.0))},
+        m_random{config.seed},
+        m_sample{0},
+        m_re(),
+        m_im()
+    {
+        for (const synth_signal& s : config.tones)
+            m_tones.emplace_back(s.from, sample_rate, s.level);
+        for (const synth_signal& s : config.chirps)
+            m_chirps.emplace_back(s.from, sample_rate, s.level);
+        for (const synth_signal& s : config.bursts)
+            m_bursts.emplace_back(s.from, sample_rate, s.level);
+
+        /* splitmix64 of the seed, xorshift state shall not be 0 */
+        m_random += 0x9e3779b97f4a7c15ULL;
+        m_random = (m_random ^ (m_random >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        m_random = (m_random ^ (m_random >> 27)) * 0x94d049bb133111ebULL;
+        m_random ^= m_random >> 31;
+        if (m_random == 0)
+            m_random = 1;
+    }
+
+    std::size_t read(uint8_t* buf, std::size_t size) override
+    {
+        std::size_t count = size / 2;
+        if (m_config.samples > 0)
+            count = static_cast<std::size_t>(std::min<uint64_t>(count, m_config.samples - m_sample));
+
+        if (count == 0)
+            return 0;
+
+        m_re.assign(count, 0.0f);
+        m_im.assign(count, 0.0f);
+
+        for (synth_oscillator& tone : m_tones) {
+            for (std::size_t n = 0; n < count; ++n)
+                tone.add(&m_re[n], &m_im[n]);
+            tone.normalise();
+        }
+
+        for (std::size_t c = 0; c < m_chirps.size(); ++c) {
+            /* frequency steps linearly from -> to, restarting every period */
+            const synth_signal& s = m_config.chirps[c];
+            const uint64_t period = std::max<uint64_t>(1, llround(s.period * m_sample_rate));
+            const double rate = 2.0 * M_PI * (s.to - s.from) / period / m_sample_rate;
+            const double rate_re = cos(rate);
+            const double rate_im = sin(rate);
+            for (std::size_t n = 0; n < count; ++n) {
+                if ((m_sample + n) % period == 0)
+                    m_chirps[c].frequency_set(s.from, m_sample_rate);
+                m_chirps[c].add(&m_re[n], &m_im[n]);
+                m_chirps[c].chirp(rate_re, rate_im);
+            }
+            m_chirps[c].normalise();
+        }
+
+        for (std::size_t b = 0; b < m_bursts.size(); ++b) {
+            const synth_signal& s = m_config.bursts[b];
+            const uint64_t period = std::max<uint64_t>(1, llround(s.period * m_sample_rate));
+            const uint64_t on = llround(s.on * m_sample_rate);
+            for (std::size_t n = 0; n < count; ++n)
+                if ((m_sample + n) % period < on)
+                    m_bursts[b].add(&m_re[n], &m_im[n]);
+                else
+                    m_bursts[b].skip();
+            m_bursts[b].normalise();
+        }
+
+        if (m_noise > 0.0f)
+            for (std::size_t n = 0; n < count; ++n) {
+                m_re[n] += m_noise * gaussian();
+                m_im[n] += m_noise * gaussian();
+            }
+
+        for (std::size_t n = 0; n < count; ++n) {
+            buf[2 * n + 0] = iq_u8_from_f32(m_re[n]);
+            buf[2 * n + 1] = iq_u8_from_f32(m_im[n]);
+        }
+
+        m_sample += count;
+
+        return count * 2;
+    }
+
+private:
+    float gaussian()
+    {
+        /* sum of four uniform [0, 1) variables minus its mean, variance 1 / 3 (scaled by m_noise) */
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 7;
+        m_random ^= m_random << 17;
+        const uint64_t r = m_random;
+        const uint32_t sum = (r & 0xffff) + ((r >> 16) & 0xffff) + ((r >> 32) & 0xffff) + (r >> 48);
+        return static_cast<float>(sum) * (1.0f / 65536.0f) - 2.0f;
+    }
+
+    synth_config m_config;
+    double m_sample_rate;
+    std::vector<synth_oscillator> m_tones;
+    std::vector<synth_oscillator> m_chirps;
+    std::vector<synth_oscillator> m_bursts;
+    float m_noise; /* scales gaussian() to the noise level per component */
+    uint64_t m_random;
+    uint64_t m_sample;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline bool synth_number(const std::string& str, double& value)
+{
+    char* end;
+
+    if (str.empty())
+        return false;
+
+    value = strtod(str.c_str(), &end);
+
+    return *end == '\0';
+}
+
+inline bool synth_parse_signal(const std::string& str, std::size_t fields, synth_signal& signal)
+{
+    /* <field>[:<field>...][@<level>], 'fields' fields */
+    std::string spec = str;
+    double values[3] = {};
+
+    signal = synth_signal{0.0, 0.0, 0.0, 0.0, SYNTH_LEVEL_DEFAULT};
+
+    const std::size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        if (!synth_number(spec.substr(at + 1), signal.level))
+            return false;
+        spec.resize(at);
+    }
+
+    for (std::size_t f = 0; f < fields; ++f) {
+        const std::size_t colon = spec.find(':');
+        if ((colon == std::string::npos) != (f + 1 == fields))
+            return false;
+        if (!synth_number(spec.substr(0, colon), values[f]))
+            return false;
+        spec = (colon == std::string::npos) ? std::string() : spec.substr(colon + 1);
+    }
+
+    signal.from = values[0];
+    if (fields == 3) {
+        signal.to = signal.on = values[1];
+        signal.period = values[2];
+        if (signal.period <= 0.0)
+            return false;
+    }
+
+    return true;
+}
+
+inline bool synth_parse_signals(const std::string& str, std::size_t fields, std::vector<synth_signal>& signals)
+{
+    /* '/' separated list */
+    std::size_t begin = 0;
+
+    for (;;) {
+        const std::size_t end = str.find('/', begin);
+        synth_signal signal;
+        if (!synth_parse_signal(str.substr(begin, end == std::string::npos ? std::string::npos : end - begin), fields, signal))
+            return false;
+        signals.push_back(signal);
+        if (end == std::string::npos)
+            return true;
+        begin = end + 1;
+    }
+}
+
+inline bool synth_parse(const char* str, synth_config& config)
+{
+    /* "synth" or "synth:<key>=<value>[,<key>=<value>...]", see the top of this file */
+    const std::size_t prefix = strlen(SYNTH_PREFIX);
+
+    config = synth_config{};
+
+    if (strncmp(str, SYNTH_PREFIX, prefix) != 0)
+        return false;
+    if (str[prefix] == '\0')
+        return true;
+    if (str[prefix] != ':')
+        return false;
+
+    const std::string spec(str + prefix + 1);
+    std::size_t begin = 0;
+
+    while (begin < spec.size()) {
+        std::size_t end = spec.find(',', begin);
+        if (end == std::string::npos)
+            end = spec.size();
+
+        const std::string pair = spec.substr(begin, end - begin);
+        const std::size_t eq = pair.find('=');
+        if (eq == std::string::npos)
+            return false;
+
+        const std::string key = pair.substr(0, eq);
+        const std::string value = pair.substr(eq + 1);
+        char* tail;
+
+        if ((key == "tones") || (key == "tone")) {
+            if (!synth_parse_signals(value, 1, config.tones))
+                return false;
+        }
+        else
+        if ((key == "chirps") || (key == "chirp")) {
+            if (!synth_parse_signals(value, 3, config.chirps))
+                return false;
+        }
+        else
+        if ((key == "bursts") || (key == "burst")) {
+            if (!synth_parse_signals(value, 3, config.bursts))
+                return false;
+        }
+        else
+        if (key == "noise") {
+            if (!synth_number(value, config.noise))
+                return false;
+        }
+        else
+        if (key == "seed") {
+            config.seed = strtoull(value.c_str(), &tail, 0);
+            if (value.empty() || (*tail != '\0'))
+                return false;
+        }
+        else
+        if (key == "samples") {
+            config.samples = strtoull(value.c_str(), &tail, 0);
+            if (value.empty() || (*tail != '\0'))
+                return false;
+        }
+        else
+            return false;
+
+        begin = end + 1;
+    }
+
+    return true;
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _SYNTH_SOURCE_HPP_ */
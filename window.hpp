@@ -0,0 +1,236 @@
+/**
+ * @file window.hpp
+ *
+ * Window functions applied to fft input samples (in the front-end pass).
+ * Coefficients are computed once per (type, N) in double precision and
+ * kept in the sample type's own format, so applying a window costs
+ * a single multiplication per sample. Windows are periodic (DFT-even),
+ * i.e. w[n] is taken from a N + 1 point symmetric window.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _WINDOW_HPP_
+#define _WINDOW_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "frontend.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define WINDOW_KAISER_BETA_DEFAULT 8.6 /* ~ -90 dB sidelobes */
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+enum class window_type
+{
+    rectangular,
+    hann,
+    hamming,
+    blackman_harris, /* 4 term, -92 dB sidelobes */
+    flat_top,        /* 5 term, for amplitude accuracy */
+    kaiser,
+};
+
+inline double window_value(window_type type, std::size_t n, std::size_t N, double beta);
+
+template<typename T>
+class window_plan
+{
+public:
+    /* beta is used by kaiser window only */
+    explicit window_plan(window_type type, std::size_t N, double beta = WINDOW_KAISER_BETA_DEFAULT) :
+        m_type{type},
+        m_beta{beta},
+        m_coefficients(type == window_type::rectangular ? 0 : N)
+    {
+        for (std::size_t n = 0; n < m_coefficients.size(); ++n)
+            m_coefficients[n] = to_coefficient(window_value(type, n, N, beta));
+    }
+
+    window_type type() const
+    {
+        return m_type;
+    }
+
+    double beta() const
+    {
+        return m_beta;
+    }
+
+    const T* coefficients() const /* nullptr for rectangular window (nothing to multiply by) */
+    {
+        return m_coefficients.empty() ? nullptr : m_coefficients.data();
+    }
+
+private:
+    static T to_coefficient(double w)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return static_cast<T>(w);
+        else
+            return frontend_sample<T>(lround(w * Q15));
+    }
+
+    window_type m_type;
+    double m_beta;
+    std::vector<T> m_coefficients;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+inline double window_bessel_i0(double x)
+{
+    /* power series of modified bessel function of the first kind, order 0 */
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 64; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-17)
+            break;
+    }
+
+    return sum;
+}
+
+inline double window_cosine_sum(const double* a, int terms, std::size_t n, std::size_t N)
+{
+    /* a0 - a1 * cos(x) + a2 * cos(2x) - ... */
+    const double x = 2.0 * M_PI * n / N;
+    double w = 0.0;
+
+    for (int k = 0; k < terms; ++k)
+        w += ((k & 1) ? -a[k] : a[k]) * cos(k * x);
+
+    return w;
+}
+
+inline double window_value(window_type type, std::size_t n, std::size_t N, double beta)
+{
+    static const double hann[] = {0.5, 0.5};
+    static const double hamming[] = {0.54, 0.46};
+    static const double blackman_harris[] = {0.35875, 0.48829, 0.14128, 0.01168};
+    static const double flat_top[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+    switch (type) {
+        case window_type::rectangular:
+            return 1.0;
+
+        case window_type::hann:
+            return window_cosine_sum(hann, 2, n, N);
+
+        case window_type::hamming:
+            return window_cosine_sum(hamming, 2, n, N);
+
+        case window_type::blackman_harris:
+            return window_cosine_sum(blackman_harris, 4, n, N);
+
+        case window_type::flat_top:
+            return window_cosine_sum(flat_top, 5, n, N);
+
+        case window_type::kaiser: {
+            const double r = 2.0 * n / N - 1.0;
+            return window_bessel_i0(beta * sqrt(1.0 - r * r)) / window_bessel_i0(beta);
+        }
+    }
+
+    return 1.0;
+}
+
+inline const char* window_to_string(window_type type)
+{
+    switch (type) {
+        case window_type::rectangular:     return "rectangular";
+        case window_type::hann:            return "hann";
+        case window_type::hamming:         return "hamming";
+        case window_type::blackman_harris: return "blackman-harris";
+        case window_type::flat_top:        return "flat-top";
+        case window_type::kaiser:          return "kaiser";
+    }
+
+    return "unknown";
+}
+
+inline bool window_from_string(const char* str, window_type& type, double& beta)
+{
+    /* kaiser window takes optional beta, e.g. "kaiser:6.5" */
+    static const window_type types[] = {window_type::rectangular, window_type::hann, window_type::hamming,
+        window_type::blackman_harris, window_type::flat_top, window_type::kaiser};
+
+    const char* colon = strchr(str, ':');
+    const std::size_t length = colon ? static_cast<std::size_t>(colon - str) : strlen(str);
+
+    for (window_type t : types) {
+        const char* name = window_to_string(t);
+        if ((strlen(name) != length) || (strncmp(str, name, length) != 0))
+            continue;
+
+        if (colon) {
+            char* end;
+            if (t != window_type::kaiser)
+                return false;
+            const double value = strtod(colon + 1, &end);
+            if ((end == colon + 1) || (*end != '\0') || (value < 0.0))
+                return false;
+            beta = value;
+        }
+
+        type = t;
+        return true;
+    }
+
+    return false;
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _WINDOW_HPP_ */
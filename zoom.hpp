@@ -0,0 +1,327 @@
+/**
+ * @file zoom.hpp
+ *
+ * Zoom fft front end (digital down-converter) - the selected slice of the
+ * captured band is mixed to baseband by a numerically controlled oscillator
+ * (32 bit phase accumulator, e^(i*phase) table) and decimated by 2^S with
+ * a chain of S half-band filters, so a small fft of the decimated samples
+ * gives the same Hz per bin as a big one of the whole band.
+ * Every half-band stage computes only its even outputs and, as every other
+ * tap of a half-band filter is zero, takes (ZOOM_HALFBAND_TAPS + 1) / 4
+ * multiplications per output; stage s runs at 1 / 2^s of the input rate,
+ * so the whole chain costs less than twice its first stage.
+ * Filter and oscillator states are carried over from block to block.
+ *
+ * @author Lukasz Wiecaszek <lukasz.wiecaszek@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ */
+
+#ifndef _ZOOM_HPP_
+#define _ZOOM_HPP_
+
+/*===========================================================================*\
+ * system header files
+\*===========================================================================*/
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+/*===========================================================================*\
+ * project header files
+\*===========================================================================*/
+#include "complex.hpp"
+#include "frontend.hpp"
+#include "window.hpp"
+
+/*===========================================================================*\
+ * preprocessor #define constants and macros
+\*===========================================================================*/
+#define ZOOM_HALFBAND_TAPS 31 /* 4 * k - 1, kaiser windowed, ~ -80 dB stopband */
+#define ZOOM_HALFBAND_BETA 7.9
+#define ZOOM_NCO_TABLE_BITS 12 /* phase truncation spurs at ~ -72 dBc */
+#define ZOOM_DECIMATION_MAX 1024
+#define ZOOM_SPAN_OVERSAMPLING 2 /* decimated sample rate to span ratio, keeps half-band transitions out of the span */
+#define ZOOM_IMAGES_MAX_DB -60.0 /* zoom_images_db() limit, dBc */
+
+/*===========================================================================*\
+ * global type definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline T zoom_coefficient(double h);
+
+template<typename T>
+class halfband_decimator
+{
+public:
+    explicit halfband_decimator() :
+        m_center{zoom_coefficient<T>(0.5)},
+        m_delay(2 * ZOOM_HALFBAND_TAPS),
+        m_position{0},
+        m_phase{0}
+    {
+        /* h[m] = sinc((m - c) / 2) / 2 * w[m], c = (L - 1) / 2, non-zero for even m only */
+        const int L = ZOOM_HALFBAND_TAPS;
+        const int c = (L - 1) / 2;
+
+        for (int m = 0; m < c; m += 2) {
+            const double x = M_PI * (m - c) / 2.0;
+            const double w = window_value(window_type::kaiser, m, L - 1, ZOOM_HALFBAND_BETA);
+            m_coefficients[m / 2] = zoom_coefficient<T>(0.5 * sin(x) / x * w);
+        }
+    }
+
+    std::size_t decimate(const complex<T>* in, std::size_t count, complex<T>* out)
+    {
+        /* out may be the same as in (out[j] is written after in[2 * j] has been read) */
+        const std::size_t L = ZOOM_HALFBAND_TAPS;
+        const std::size_t c = (L - 1) / 2;
+        std::size_t produced = 0;
+
+        for (std::size_t n = 0; n < count; ++n) {
+            /* every sample is stored twice, so last L samples are always contiguous */
+            m_delay[m_position] = in[n];
+            m_delay[m_position + L] = in[n];
+            m_position = (m_position + 1) % L;
+
+            m_phase ^= 1;
+            if (m_phase == 0)
+                continue;
+
+            const complex<T>* x = &m_delay[m_position]; /* oldest sample first */
+            complex<T> sum = x[c] * m_center;
+            for (std::size_t m = 0; m < c; m += 2)
+                sum += (x[m] + x[L - 1 - m]) * m_coefficients[m / 2];
+            out[produced++] = sum;
+        }
+
+        return produced;
+    }
+
+    void reset()
+    {
+        std::fill(m_delay.begin(), m_delay.end(), complex<T>{});
+        m_position = 0;
+        m_phase = 0;
+    }
+
+private:
+    T m_center;
+    T m_coefficients[(ZOOM_HALFBAND_TAPS + 1) / 4];
+    std::vector<complex<T>> m_delay;
+    std::size_t m_position; /* oldest sample (to be replaced next) */
+    unsigned m_phase;
+};
+
+template<typename T>
+class zoom_ddc
+{
+public:
+    /* shifts 'offset' Hz (relative to the tuned frequency) to dc and decimates by 'decimation' (power of 2) */
+    explicit zoom_ddc(double offset, double sample_rate, std::size_t decimation) :
+        m_decimation{decimation},
+        m_table(std::size_t(1) << ZOOM_NCO_TABLE_BITS),
+        m_phase{0},
+        m_step{static_cast<uint32_t>(static_cast<int64_t>(llround(-offset / sample_rate * 4294967296.0)))},
+        m_stages()
+    {
+        for (std::size_t k = 0; k < m_table.size(); ++k) {
+            const double x = 2.0 * M_PI * k / m_table.size();
+            m_table[k] = complex<T>(zoom_coefficient<T>(cos(x)), zoom_coefficient<T>(sin(x)));
+        }
+
+        for (std::size_t d = decimation; d > 1; d /= 2)
+            m_stages.emplace_back();
+    }
+
+    std::size_t decimation() const
+    {
+        return m_decimation;
+    }
+
+    std::size_t process(complex<T>* iq, std::size_t count, complex<T>* out)
+    {
+        /* mixes iq in place and writes count / decimation (rounded either way) samples to out */
+        for (std::size_t n = 0; n < count; ++n, m_phase += m_step)
+            iq[n] *= m_table[m_phase >> (32 - ZOOM_NCO_TABLE_BITS)];
+
+        if (m_stages.empty()) {
+            std::copy(iq, iq + count, out);
+            return count;
+        }
+
+        for (std::size_t s = 0; s + 1 < m_stages.size(); ++s)
+            count = m_stages[s].decimate(iq, count, iq);
+
+        return m_stages.back().decimate(iq, count, out);
+    }
+
+    void reset() /* on discontinuity */
+    {
+        for (halfband_decimator<T>& stage : m_stages)
+            stage.reset();
+    }
+
+private:
+    std::size_t m_decimation;
+    std::vector<complex<T>> m_table; /* e^(2*pi*i*k/table size) */
+    uint32_t m_phase;
+    uint32_t m_step;
+    std::vector<halfband_decimator<T>> m_stages;
+};
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * inline function/variable definitions
+\*===========================================================================*/
+namespace ymn
+{
+
+template<typename T>
+inline T zoom_coefficient(double h)
+{
+    if constexpr (std::is_floating_point<T>::value)
+        return static_cast<T>(h);
+    else
+        return frontend_sample<T>(lround(h * Q15));
+}
+
+inline std::size_t zoom_decimation(double sample_rate, double span)
+{
+    /* biggest power of 2 still keeping decimated sample rate at or above ZOOM_SPAN_OVERSAMPLING * span, */
+    /* at 1x tones just outside the span would alias onto its edges with no attenuation at all */
+    std::size_t decimation = 1;
+
+    while ((decimation < ZOOM_DECIMATION_MAX) && (sample_rate / (decimation * 2) >= ZOOM_SPAN_OVERSAMPLING * span))
+        decimation *= 2;
+
+    return decimation;
+}
+
+template<typename T>
+inline std::vector<complex<double>> zoom_tone(double offset, double tone, double sample_rate, std::size_t decimation)
+{
+    /* down-converts a -6 dBFS tone sitting at 'tone' (as zoom_ddc for 'offset' does), */
+    /* returns decimated outputs once filter transients are gone */
+    const std::size_t chunk = 1024;
+    const std::size_t outputs = 256;
+    const std::size_t settled = 32; /* outputs taken by filter transients */
+    zoom_ddc<T> ddc(offset, sample_rate, decimation);
+    std::vector<complex<T>> iq(chunk);
+    std::vector<complex<T>> out;
+    std::size_t n = 0;
+
+    auto to_double = [](T v) -> double {
+        if constexpr (std::is_floating_point<T>::value)
+            return v;
+        else
+            return static_cast<double>(v.value()) / Q15;
+    };
+
+    while (out.size() < settled + outputs) {
+        for (std::size_t k = 0; k < chunk; ++k, ++n) {
+            const double x = 2.0 * M_PI * tone * n / sample_rate;
+            iq[k] = complex<T>(zoom_coefficient<T>(0.5 * cos(x)), zoom_coefficient<T>(0.5 * sin(x)));
+        }
+        const std::size_t size = out.size();
+        out.resize(size + chunk);
+        out.resize(size + ddc.process(iq.data(), chunk, out.data() + size));
+    }
+
+    std::vector<complex<double>> tone_out(outputs);
+    for (std::size_t k = 0; k < outputs; ++k)
+        tone_out[k] = complex<double>(to_double(out[settled + k].real()), to_double(out[settled + k].imag()));
+
+    return tone_out;
+}
+
+template<typename T>
+inline double zoom_images_db(double offset, double sample_rate, std::size_t decimation)
+{
+    /* mixes a -6 dBFS tone sitting at 'offset' down to dc (as zoom_ddc does) and returns the power */
+    /* of everything but dc (images, spurs, harmonics) relative to the dc one, in dBc */
+    const std::vector<complex<double>> out = zoom_tone<T>(offset, offset, sample_rate, decimation);
+    const std::size_t outputs = out.size();
+
+    double dc_re = 0.0;
+    double dc_im = 0.0;
+    for (std::size_t k = 0; k < outputs; ++k) {
+        dc_re += out[k].real() / outputs;
+        dc_im += out[k].imag() / outputs;
+    }
+
+    double rest = 0.0;
+    for (std::size_t k = 0; k < outputs; ++k) {
+        const double re = out[k].real() - dc_re;
+        const double im = out[k].imag() - dc_im;
+        rest += (re * re + im * im) / outputs;
+    }
+
+    return 10.0 * log10((rest + 1e-30) / (dc_re * dc_re + dc_im * dc_im + 1e-30));
+}
+
+template<typename T>
+inline double zoom_edge_images_db(double offset, double span, double sample_rate, std::size_t decimation)
+{
+    /* tones at +/-(decimated sample rate - span / 2) around 'offset' lie outside the span, but fold onto */
+    /* its edges - returns the larger of their powers left after decimation, relative to the one they had */
+    const double fold = sample_rate / decimation - span / 2.0;
+    double worst = 0.0;
+
+    if (decimation == 1)
+        return 10.0 * log10(1e-30 / 0.25); /* nothing folds */
+
+    for (const double tone : {offset - fold, offset + fold}) {
+        const std::vector<complex<double>> out = zoom_tone<T>(offset, tone, sample_rate, decimation);
+        double power = 0.0;
+        for (const complex<double>& c : out)
+            power += (c.real() * c.real() + c.imag() * c.imag()) / out.size();
+        worst = std::max(worst, power);
+    }
+
+    return 10.0 * log10((worst + 1e-30) / 0.25);
+}
+
+template<typename T>
+inline void zoom_window(complex<T>* iq, const complex<T>* src, const T* window, const size_t N)
+{
+    /* decimated samples are windowed on their way to the fft input buffer, window may be nullptr */
+    if (window == nullptr)
+        std::copy(src, src + N, iq);
+    else
+        for (size_t n = 0; n < N; ++n)
+            iq[n] = src[n] * window[n];
+}
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * global object declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+/*===========================================================================*\
+ * function forward declarations
+\*===========================================================================*/
+namespace ymn
+{
+
+} /* end of namespace ymn */
+
+#endif /* _ZOOM_HPP_ */